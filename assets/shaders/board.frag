@@ -0,0 +1,38 @@
+#version 460 core
+
+// Row x of the board, 32 cells per texel with column y at bit y % 32 of texel y / 32. A windowed texture
+// only holds the resident rows and columns, wrapped around its own size, which is a power of two.
+uniform usampler2D board;
+uniform vec4 resident;
+uniform bool windowed;
+
+// Matches renderer_view_block_t
+layout(std140) uniform View
+{
+    mat4 projection;
+    vec4 aliveColor;
+    vec4 deadColor;
+    vec2 gridCenter;
+    vec2 viewport;
+    float cellWidth;
+};
+
+out vec4 FragColor;
+
+void main()
+{
+    // Cells are cellWidth pixels wide with the corner of cell gridCenter in the middle of the window, as the point sprites were
+    vec2 cell = floor(gridCenter + (gl_FragCoord.yx - viewport.yx / 2.0) / cellWidth);
+
+    if (any(lessThan(cell, resident.xy)) || any(greaterThanEqual(cell, resident.zw)))
+        discard;
+
+    ivec2 position = ivec2(cell);
+    ivec2 texel = ivec2(position.y / 32, position.x);
+    if (windowed)
+        texel &= textureSize(board, 0) - 1;
+
+    uint word = texelFetch(board, texel, 0).r;
+
+    FragColor = vec4(((word >> uint(position.y % 32)) & 1u) != 0u ? aliveColor.rgb : deadColor.rgb, 1.0);
+}
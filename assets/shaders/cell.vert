@@ -1,21 +1,23 @@
 #version 460 core
 
 layout (location = 0) in vec2 point;
+// Row and column of one live cell per instance, for the instanced renderer
+layout (location = 1) in ivec2 instanceCell;
 
 uniform bool accelerate;
+uniform bool instanced;
 uniform vec3 cell;
-uniform vec2 gridCenter;
 
-uniform float cellWidth = 10.0;
-uniform vec3 aliveColor = vec3(1.0, 1.0, 1.0);
-uniform vec3 deadColor = vec3(0.3, 0.3, 0.3);
-
-uniform mat4 projection = mat4(
-    vec4(1.0, 0.0, 0.0, 0.0),
-    vec4(0.0, 1.0, 0.0, 0.0),
-    vec4(0.0, 0.0, 1.0, 0.0),
-    vec4(0.0, 0.0, 0.0, 1.0)
-);
+// Matches renderer_view_block_t
+layout(std140) uniform View
+{
+    mat4 projection;
+    vec4 aliveColor;
+    vec4 deadColor;
+    vec2 gridCenter;
+    vec2 viewport;
+    float cellWidth;
+};
 
 uniform mat4 view = mat4(
     vec4(1.0, 0.0, 0.0, 0.0),
@@ -36,14 +38,15 @@ out vec4 color;
 void main()
 {
     vec4 position = vec4(point, 1.0, 1.0);
+    vec3 current = instanced ? vec3(instanceCell, 1.0) : cell;
 
-    if (accelerate) {
+    if (accelerate || instanced) {
         // Matrices are column major ordered...
         mat4 translatedView = mat4(
             vec4(1.0, 0.0, 0.0, 0.0),
             vec4(0.0, 1.0, 0.0, 0.0),
             vec4(0.0, 0.0, 1.0, 0.0),
-            vec4(cell.y - gridCenter.y, cell.x - gridCenter.x, -1.0, 1.0)
+            vec4(current.y - gridCenter.y, current.x - gridCenter.x, -1.0, 1.0)
         );
         
         gl_Position = projection * translatedView * model * position;
@@ -53,9 +56,9 @@ void main()
 
     gl_PointSize = cellWidth;
 
-    if (cell.z == 1.0) {
-        color = vec4(aliveColor, 1.0);
+    if (current.z == 1.0) {
+        color = aliveColor;
     } else{
-        color = vec4(deadColor, 1.0);
+        color = deadColor;
     }
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#version 460 core
+
+// One texel per block of the pyramid level drawn, numBlocks of them from block firstBlock. The red channel
+// is the fraction of the block alive, rounded up so a single live cell is never lost.
+uniform sampler2D blocks;
+uniform float blockSize;
+uniform vec2 firstBlock;
+uniform vec2 numBlocks;
+uniform vec2 boardSize;
+uniform bool anyAlive;
+
+// Matches renderer_view_block_t
+layout(std140) uniform View
+{
+    mat4 projection;
+    vec4 aliveColor;
+    vec4 deadColor;
+    vec2 gridCenter;
+    vec2 viewport;
+    float cellWidth;
+};
+
+out vec4 FragColor;
+
+void main()
+{
+    vec2 cell = gridCenter + (gl_FragCoord.yx - viewport.yx / 2.0) / cellWidth;
+
+    if (any(lessThan(cell, vec2(0.0))) || any(greaterThanEqual(cell, boardSize)))
+        discard;
+
+    vec2 block = floor(cell / blockSize) - firstBlock;
+
+    if (any(lessThan(block, vec2(0.0))) || any(greaterThanEqual(block, numBlocks)))
+        discard;
+
+    float density = texelFetch(blocks, ivec2(block.yx), 0).r;
+
+    FragColor = vec4(anyAlive ? (density > 0.0 ? aliveColor.rgb : deadColor.rgb) : mix(deadColor.rgb, aliveColor.rgb, density), 1.0);
+}
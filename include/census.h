@@ -0,0 +1,97 @@
+#ifndef CENSUS_H
+
+#define CENSUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "life.h"
+#include "utils/std_utils.h"
+#include "utils/thread_utils.h"
+
+// Objects are followed in isolation for at most this many generations before they count as unclassified
+#define CENSUS_MAX_PERIOD 32
+// Objects with a larger bounding box are not simulated, they count as unclassified
+#define CENSUS_MAX_AREA 4096
+
+typedef enum {
+    census_still_life,
+    census_oscillator,
+    census_spaceship,
+    /**
+     * Did not repeat within CENSUS_MAX_PERIOD generations, died, or was too large to follow
+    */
+    census_unclassified,
+} census_kind_e;
+
+/**
+ * A kind of object, the same species whatever its phase, rotation or reflection
+*/
+typedef struct census_species_t
+{
+    census_kind_e kind;
+    int period;
+    /**
+     * The phase and orientation that sorts first, as rows x columns cells in row major order
+    */
+    int rows;
+    int columns;
+    bool *cells;
+    long population;
+    /**
+     * Objects of this species found by the last take
+    */
+    long count;
+} census_species_t;
+
+typedef struct census_object_t
+{
+    life_bounds_t bounds;
+    long population;
+    int species;
+    /**
+     * How far a spaceship moves each period, in board rows and columns
+    */
+    int dx;
+    int dy;
+} census_object_t;
+
+typedef struct census_shape_t
+{
+    int rows;
+    int columns;
+    bool *cells;
+    uint64_t hash;
+    int species;
+    int dx;
+    int dy;
+} census_shape_t;
+
+/**
+ * Splits the board into pieces of touching live cells, counting diagonal neighbors as touching, and
+ * groups pieces that are close enough to affect each other. Each piece is classified by following it on
+ * its own, and the pieces of a group that do not repeat alone are classified together, so oscillators
+ * that fall apart on some phases are still one object. Classifications are cached by exact shape, so
+ * only shapes never seen before are simulated.
+*/
+typedef struct census_t
+{
+    int num_species;
+    census_species_t *species;
+    size_t num_objects;
+    census_object_t *objects;
+    int num_threads;
+    census_shape_t *_shapes;
+    size_t _num_shapes;
+    size_t _shapes_capacity;
+    int _unclassified;
+    /**
+     * Labels and classifies the objects of the board's current generation, replacing objects and the species counts
+    */
+    void (*take)(struct census_t *self, life_t *life);
+} census_t;
+
+census_t *init_census(void);
+void destroy_census(census_t *self);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef IMAGE_H
+
+#define IMAGE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "life.h"
+#include "utils/std_utils.h"
+#include "utils/string_utils.h"
+#include "utils/thread_utils.h"
+
+/**
+ * A decoded PNG, JPEG or BMP used to seed a board.
+ * Pixels darker than threshold become live cells, so a threshold of 0 leaves the board empty. Transparent pixels count as white.
+*/
+typedef struct image_t
+{
+    int rows;
+    int columns;
+    int _channels;
+    unsigned char *_pixels;
+    unsigned char threshold;
+    /**
+     * Spread the threshold over an 8x8 ordered dither instead of a hard cut off, so grey becomes a density of cells
+    */
+    bool dither;
+    /**
+     * Adds the image's live cells at its own size, with its top left pixel at (top, left) as the board is drawn
+    */
+    void (*load)(struct image_t *self, life_t *life, int top, int left);
+    /**
+     * Adds the image's live cells scaled to cover the whole board
+    */
+    void (*load_scaled)(struct image_t *self, life_t *life);
+} image_t;
+
+image_t *init_image(const char *file_name);
+void destroy_image(image_t *self);
+
+#endif
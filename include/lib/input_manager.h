@@ -2,6 +2,7 @@
 
 #define INPUT_MANAGER_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include "lib/vector.h"
 #include "utils/std_utils.h"
@@ -12,6 +13,11 @@ typedef struct input_t {
      * Accepts time since last render
     */
     void (*callback)(struct timeval *delta_time);
+    /**
+     * Fires once when the key goes down instead of every frame it is held
+    */
+    bool once;
+    bool _held;
 } input_t;
 
 typedef struct input_manager_t
@@ -3,17 +3,44 @@
 #define SHADER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <cglm/cglm.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "utils/std_utils.h"
 #include "utils/string_utils.h"
 
+/**
+ * A shader source embedded at build time, named after its file in assets/shaders
+*/
+typedef struct shader_source_t
+{
+    const char *name;
+    const char *source;
+} shader_source_t;
+
+typedef struct shader_uniform_t
+{
+    char *name;
+    int location;
+} shader_uniform_t;
+
 typedef struct shader_t
 {
     unsigned int ID;
+    /**
+     * Every active uniform outside a block, sorted by name, resolved once when the program is linked
+    */
+    int num_uniforms;
+    shader_uniform_t *uniforms;
     void (*use)(struct shader_t *self);
+    int (*getUniformLocation)(struct shader_t *self, const char *uniformVarName);
+    /**
+     * Points the std140 uniform block blockName at a uniform buffer binding point
+    */
+    void (*bindUniformBlock)(struct shader_t *self, const char *blockName, unsigned int binding);
     void (*setUniformBool)(struct shader_t *self, const char *uniformVarName, bool val);
     void (*setUniformInt)(struct shader_t *self, const char *uniformVarName, int val);
     void (*setUniformFloat)(struct shader_t *self, const char *uniformVarName, float val);
@@ -23,7 +50,14 @@ typedef struct shader_t
     void (*setUniformM4F)(struct shader_t *self, const char *uniformVarName, mat4 mat);
 } shader_t;
 
+extern const shader_source_t embedded_shaders[];
+extern const int num_embedded_shaders;
+
+/**
+ * Shaders are named after their files in assets/shaders, linked programs are cached across runs
+*/
 shader_t *init_shader(const char *vertex, const char *fragment);
+shader_t *init_compute_shader(const char *compute);
 void destroy_shader(shader_t *self);
 
 #endif
\ No newline at end of file
@@ -5,25 +5,211 @@
 #include "utils/std_utils.h"
 #include "utils/string_utils.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
+// Side of the square tiles whose changes are tracked in tile_revisions, a power of two.
+// The file backed board may track larger tiles, see tile_size.
+#define LIFE_TILE_SIZE 64
+
+/**
+ * live() samples the board every LIFE_SAMPLE_INTERVAL generations to pick its sweep, comparing the
+ * estimated cost of each, in nanoseconds measured on the benchmark boards. A switch needs the other
+ * sweep to be LIFE_SWEEP_MARGIN cheaper, and is not made to the sparse sweep while the swept area
+ * grows faster than LIFE_SWEEP_MAX_GROWTH per sample.
+*/
+#define LIFE_SAMPLE_INTERVAL 32
+#define LIFE_DENSE_NS_PER_CELL 2.5
+#define LIFE_SPARSE_NS_PER_CELL 4.0
+#define LIFE_MARK_NS_PER_TILE 2.0
+#define LIFE_SWEEP_MARGIN 0.25
+#define LIFE_SWEEP_MAX_GROWTH 1.5
+
+typedef enum {
+    life_dense_sweep,
+    life_sparse_sweep,
+} life_sweep_e;
+
+typedef enum {
+    life_or,
+    life_and_not,
+    life_xor,
+} life_edit_op_e;
+
+/**
+ * Cells packed 64 to a word. Row r starts at bits + r * words, bit j of it is column j.
+*/
+typedef struct life_bits_t
+{
+    int rows;
+    int columns;
+    int words;
+    uint64_t *bits;
+} life_bits_t;
+
+/**
+ * Inclusive rectangle of cells, empty when max_x < min_x
+*/
+typedef struct life_bounds_t
+{
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+} life_bounds_t;
+
+typedef struct life_stats_t
+{
+    long generation;
+    long population;
+    long births;
+    long deaths;
+    double density;
+} life_stats_t;
+
 typedef struct life_t
 {
     int rows;
     int columns;
     bool **grid;
     bool **shadow_grid;
+    /**
+     * Bounding box of the live cells in grid, live() only sweeps this plus a one cell margin
+    */
+    life_bounds_t bounds;
+    life_bounds_t _shadow_bounds;
+    /**
+     * Start small and double rows or columns whenever live cells get near an edge.
+     * New space is split evenly on both sides, origin_x and origin_y count how far the
+     * original cell (0, 0) has moved. Only the in memory board grows.
+    */
+    bool auto_grow;
+    int origin_x;
+    int origin_y;
+    /**
+     * Join the top edge to the bottom and the left edge to the right, set before the first generation.
+     * Only the in memory board wraps, and it never grows.
+    */
+    bool torus;
+    /**
+     * Counted by live() in the same pass that computes the generation.
+     * refresh() recounts the population and zeroes births and deaths.
+    */
+    life_stats_t stats;
+    /**
+     * Keep a summed-area table over the live bounds so count_alive takes constant time.
+     * It is rebuilt by the first count_alive after each generation. Ignored by the file backed board.
+    */
+    bool index_area;
+    uint32_t *_area_table;
+    size_t _area_table_size;
+    life_bounds_t _area_bounds;
+    bool _area_stale;
+    /**
+     * Bumped whenever the board changes. tile_revisions holds the revision at which a cell of each
+     * tile_size square tile last changed, in row major order, so a consumer that remembers the
+     * revision it last saw only has to revisit the newer tiles. A board that grows restamps every tile.
+     * tile_size is LIFE_TILE_SIZE, or a larger power of two on a file backed board too big for its
+     * memory budget to hold a revision per LIFE_TILE_SIZE tile.
+    */
+    unsigned long revision;
+    int tile_size;
+    int tile_rows;
+    int tile_columns;
+    unsigned long *tile_revisions;
+    /**
+     * How live() visits the in memory board: every cell of the live bounds, or only the tiles next to a
+     * tile that changed since the last generation. init_life sets adaptive, which lets live() switch
+     * between them as the board settles or gets busy, logging each switch. Ignored by the file backed board.
+    */
+    life_sweep_e sweep;
+    bool adaptive;
+    unsigned long _live_revision;
+    unsigned char *_active_tiles;
+    size_t _active_size;
+    double _sampled_area;
     void (*print)(struct life_t *self);
     void (*print_shadow)(struct life_t *self);
     void (*seed)(struct life_t *self);
     void (*swap)(struct life_t *self);
     void (*live)(struct life_t *self);
+    /**
+     * Writes a single cell of the current generation
+    */
     void (*set_alive)(struct life_t *self, int x, int y, bool alive);
     bool (*get_alive)(struct life_t *self, int x, int y);
     int (*get_num_alive_neighbors)(struct life_t *self, int x, int y);
+    /**
+     * Recomputes bounds after cells were written straight into grid
+    */
+    void (*refresh)(struct life_t *self);
+    /**
+     * Live cells in rows x0 to x1 and columns y0 to y1, inclusive and clipped to the board
+    */
+    long (*count_alive)(struct life_t *self, int x0, int y0, int x1, int y1);
+    /**
+     * Packs words first_word to first_word + num_words - 1 of row x of the current generation into bits,
+     * 64 cells to a word with column j at bit j % 64 of word j / 64. A row has (columns + 63) / 64 words.
+    */
+    void (*pack_row)(struct life_t *self, int x, int first_word, int num_words, uint64_t *bits);
+    /**
+     * Batched edits of the current generation, a word at a time and clipped to the board.
+     * Called while live() runs on another thread they are queued, and applied once the generation is done.
+     * Edits can leave bounds larger than the live cells until the next generation.
+     *
+     * stamp combines bits into the board with its lowest row and column at (x, y), after turning it
+     * orientation quarter turns, plus 4 to mirror it first. points holds count (x, y) pairs.
+    */
+    void (*stamp)(struct life_t *self, const life_bits_t *bits, int x, int y, int orientation, life_edit_op_e op);
+    void (*fill)(struct life_t *self, life_bounds_t area, bool alive);
+    void (*edit_points)(struct life_t *self, const int *points, size_t count, life_edit_op_e op);
+    /**
+     * GL texture holding the current generation of a board computed on the GPU, bit packed the way the
+     * texture renderer draws it. 0 for the boards computed on the CPU.
+    */
+    unsigned int texture;
+    void *_edits;
+    void (*_edit_row)(struct life_t *self, int x, int y, const uint64_t *bits, int offset, int count, life_edit_op_e op);
+    void *_engine;
+    void (*_destroy)(struct life_t *self);
 } life_t;
 
 life_t *init_life(int rows, int columns);
+bool bounds_empty(life_bounds_t bounds);
+life_bounds_t bounds_union(life_bounds_t a, life_bounds_t b);
+life_bounds_t bounds_intersect(life_bounds_t a, life_bounds_t b);
+life_bounds_t bounds_expand(life_bounds_t bounds, int margin, int rows, int columns);
+/**
+ * Sizes tile_revisions for the board and stamps every tile with the current revision, tile_size defaults to LIFE_TILE_SIZE
+*/
+void reset_tiles(life_t *self);
+/**
+ * A board kept bit packed in a scratch file instead of memory, for boards larger than RAM.
+ * Generations are streamed through in bands of rows using at most memory_budget bytes, tile revisions included.
+ * grid and shadow_grid are NULL, cells are only reachable through get_alive, set_alive and the batched edits.
+*/
+life_t *init_file_life(int rows, int columns, const char *file_name, size_t memory_budget);
+/**
+ * A board stepped by a compute shader in the current GL 4.6 context, which only leaves the GPU when a cell
+ * is asked for. After each generation bounds cover the whole board and stats only hold the generation,
+ * until the first call that reads cells brings them up to date. Use it from the thread of the GL context.
+*/
+life_t *init_gpu_life(int rows, int columns);
 void destroy_life(life_t *self);
 
+life_bits_t *init_bits(int rows, int columns);
+/**
+ * Packs a rectangle of the board, for stamping it elsewhere
+*/
+life_bits_t *pack_life(life_t *life, life_bounds_t area);
+void destroy_bits(life_bits_t *self);
+/**
+ * Shared by the engines: live() brackets each generation with begin_live and end_live,
+ * which applies the edits queued in the meantime
+*/
+void init_edits(life_t *self);
+void begin_live(life_t *self);
+void end_live(life_t *self);
+void destroy_edits(life_t *self);
+
 #endif
\ No newline at end of file
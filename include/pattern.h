@@ -0,0 +1,49 @@
+#ifndef PATTERN_H
+
+#define PATTERN_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "life.h"
+#include "utils/std_utils.h"
+#include "utils/string_utils.h"
+#include "utils/thread_utils.h"
+
+typedef enum {
+    pattern_rle,
+    pattern_plaintext,
+    pattern_life_106,
+} pattern_format_e;
+
+/**
+ * A pattern file mapped into memory.
+ * rows and columns are the size of the pattern's bounding box, found from the
+ * header (RLE) or a pre-scan of the mapped file (plaintext, Life 1.06).
+*/
+typedef struct pattern_t
+{
+    pattern_format_e format;
+    const char *_data;
+    size_t _length;
+    const char *_body;
+    int rows;
+    int columns;
+    long _min_x;
+    long _min_y;
+    /**
+     * Decodes the pattern straight into the board's rows, with the top left cell of the
+     * pattern at (top, left) measured from the top left corner of the board as it is drawn.
+     * Live cells are added to the board, cells that fall outside of it are dropped.
+    */
+    void (*load)(struct pattern_t *self, life_t *life, int top, int left);
+} pattern_t;
+
+pattern_t *init_pattern(const char *file_name);
+void destroy_pattern(pattern_t *self);
+
+/**
+ * Streams the live bounds of the board out as RLE without building the encoded pattern in memory
+*/
+void write_rle(life_t *life, const char *file_name);
+
+#endif
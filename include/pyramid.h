@@ -0,0 +1,76 @@
+#ifndef PYRAMID_H
+
+#define PYRAMID_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "life.h"
+#include "utils/std_utils.h"
+
+// The finest stored level has blocks of a tile, or larger ones until it has at most this many along a side
+#define PYRAMID_MAX_BLOCKS 1024
+
+typedef struct pyramid_level_t
+{
+    // A long, the top level of a board 2^30 cells or more across is 2^31 wide
+    long block_size;
+    int rows;
+    int columns;
+    // Bytes per count, 1, 2, 4 or 8, the fewest that hold the count of a block that is entirely alive
+    int _width;
+    void *_counts;
+} pyramid_level_t;
+
+/**
+ * Population counts of 2x2, 4x4, 8x8 ... blocks of a board, up to one block covering all of it.
+ * Block (x, y) of a level covers the same rows and columns the board does scaled down by its block size.
+ * Only blocks of at least a tile are stored, from the first level with at most PYRAMID_MAX_BLOCKS of them
+ * along a side, so their memory is bounded whatever the size of the board. Finer blocks are counted from
+ * the board when asked for. Either way the work follows the area asked about, not the board.
+*/
+typedef struct pyramid_t
+{
+    int num_levels;
+    /**
+     * levels[k] counts blocks 2^(k + 1) cells wide, only levels from first_level up hold counts
+    */
+    pyramid_level_t *levels;
+    int first_level;
+    int _board_rows;
+    int _board_columns;
+    /**
+     * Per block of first_level, one more than the board revision it was last counted at, 0 if never counted
+    */
+    unsigned long *_revisions;
+    uint64_t *_block_counts;
+    uint64_t *_row;
+    int _row_words;
+    /**
+     * Recounts the stored blocks over the cells of area whose tiles changed since they were counted,
+     * then the blocks above them. Everything is dropped when the board changed size.
+    */
+    void (*update)(struct pyramid_t *self, life_t *life, life_bounds_t area);
+    /**
+     * Counts of a rectangle of blocks of any level, row by row, bringing stored levels up to date first
+    */
+    void (*count_blocks)(struct pyramid_t *self, life_t *life, int level, life_bounds_t blocks, uint64_t *counts);
+    /**
+     * Read a stored level, as of the last update covering the block
+    */
+    uint64_t (*get_count)(struct pyramid_t *self, int level, int x, int y);
+    /**
+     * Fraction of the block's cells on the board that are alive
+    */
+    double (*get_density)(struct pyramid_t *self, int level, int x, int y);
+    /**
+     * Follows the most populated child down from the top, returning the cells of the block reached at level,
+     * or at first_level for finer levels. Quickly finds a busy region, though not always the single most
+     * populated block of that level. Needs an update covering the whole board.
+    */
+    life_bounds_t (*find_densest)(struct pyramid_t *self, int level);
+} pyramid_t;
+
+pyramid_t *init_pyramid(void);
+void destroy_pyramid(pyramid_t *self);
+
+#endif
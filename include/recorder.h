@@ -0,0 +1,65 @@
+#ifndef RECORDER_H
+
+#define RECORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "life.h"
+#include "utils/std_utils.h"
+#include "utils/string_utils.h"
+
+/**
+ * Recordings are an append only file: a header with the board size, then one record per generation.
+ * Every keyframe_interval generations the record is a keyframe holding the whole board as varint
+ * run lengths, in between it is a delta holding the varint gaps between the cells that flipped.
+*/
+typedef struct recorder_t
+{
+    FILE *_file;
+    int rows;
+    int columns;
+    int keyframe_interval;
+    long generation;
+    bool *_previous;
+    uint8_t *_buffer;
+    size_t _buffer_size;
+    /**
+     * Appends the board's current generation to the recording
+    */
+    void (*record)(struct recorder_t *self, life_t *life);
+} recorder_t;
+
+recorder_t *init_recorder(const char *file_name, life_t *life, int keyframe_interval);
+void destroy_recorder(recorder_t *self);
+
+typedef struct player_t
+{
+    FILE *_file;
+    int rows;
+    int columns;
+    long generations;
+    /**
+     * The generation currently loaded onto the board, -1 before the first seek or step
+    */
+    long generation;
+    int _num_keyframes;
+    long *_keyframe_generations;
+    long *_keyframe_offsets;
+    uint8_t *_buffer;
+    size_t _buffer_size;
+    /**
+     * Loads the nearest keyframe at or before generation and applies the deltas after it
+    */
+    void (*seek)(struct player_t *self, life_t *life, long generation);
+    /**
+     * Advances the board by one recorded generation, returns false at the end of the recording
+    */
+    bool (*step)(struct player_t *self, life_t *life);
+} player_t;
+
+player_t *init_player(const char *file_name);
+void destroy_player(player_t *self);
+
+#endif
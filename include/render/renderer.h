@@ -0,0 +1,103 @@
+#ifndef RENDERER_H
+
+#define RENDERER_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cglm/cglm.h>
+#include <glad/glad.h>
+#include "life.h"
+#include "pyramid.h"
+#include "lib/shader.h"
+#include "render/upload_ring.h"
+#include "utils/std_utils.h"
+
+/**
+ * What the window shows: a cell is cell_width pixels wide, and grid_center is the board row and column
+ * under the middle of the window
+*/
+typedef struct renderer_view_t
+{
+    int width;
+    int height;
+    float cell_width;
+    vec2 grid_center;
+    vec3 alive_color;
+    vec3 dead_color;
+} renderer_view_t;
+
+#define RENDERER_VIEW_BINDING 0
+
+/**
+ * The View uniform block of the renderers' shaders, std140. The projection fits the window to
+ * width / cell_width by height / cell_width cells around the origin.
+*/
+typedef struct renderer_view_block_t
+{
+    mat4 projection;
+    vec4 alive_color;
+    vec4 dead_color;
+    vec2 grid_center;
+    vec2 viewport;
+    float cell_width;
+    float _padding[3];
+} renderer_view_block_t;
+
+/**
+ * Draws a board into the current GL context. set_view is called whenever the window or the camera
+ * changes, draw once per frame.
+*/
+typedef struct renderer_t
+{
+    shader_t *shader;
+    renderer_view_t view;
+    /**
+     * Uniform buffer holding view as a renderer_view_block_t, uploaded by set_view in one go
+    */
+    unsigned int view_buffer;
+    void (*set_view)(struct renderer_t *self, const renderer_view_t *view);
+    void (*draw)(struct renderer_t *self, life_t *life);
+    void *_state;
+    void (*_destroy)(struct renderer_t *self);
+} renderer_t;
+
+/**
+ * One point sprite draw per cell. With accelerate the vertex shader places each point from the cell
+ * uniform, otherwise a view matrix is uploaded for every cell.
+*/
+renderer_t *init_point_renderer(bool accelerate);
+/**
+ * The point sprites of the point renderer, but only for live cells and all in one instanced draw.
+ * The board is cleared to the dead color first.
+*/
+renderer_t *init_instanced_renderer(void);
+/**
+ * Uploads the board bit packed into an R32UI texture and draws it with a single fullscreen triangle.
+ * The texture only holds the tiles around the view, so its size follows the window rather than the board.
+*/
+renderer_t *init_texture_renderer(void);
+/**
+ * For views with cells under a pixel wide. Draws the blocks of the density pyramid level closest to a
+ * pixel, each in the alive color if any of its cells are alive, or with any_alive false, blended from the
+ * dead to the alive color by the fraction alive.
+*/
+renderer_t *init_density_renderer(bool any_alive);
+void destroy_renderer(renderer_t *self);
+
+/**
+ * Shared by the renderers: makes view_buffer for the shader's View block and sets set_view to fill it
+*/
+void init_view_block(renderer_t *self);
+/**
+ * Uses the shader with the renderer's view_buffer bound to the View block
+*/
+void use_renderer(renderer_t *self);
+
+/**
+ * The board rows and columns the view shows any part of, empty if it shows none
+*/
+life_bounds_t visible_cells(const renderer_view_t *view, int rows, int columns);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef UPLOAD_RING_H
+
+#define UPLOAD_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <glad/glad.h>
+#include "utils/std_utils.h"
+
+#define UPLOAD_RING_SLOTS 3
+
+/**
+ * A buffer mapped once for good and split into UPLOAD_RING_SLOTS slots, so a frame's data is written
+ * straight into memory the GPU reads from while it is still drawing the frames before. Each slot is
+ * fenced when the commands reading it are issued, and begin only waits if the GPU is a whole ring behind.
+*/
+typedef struct upload_ring_t
+{
+    GLenum target;
+    unsigned int buffer;
+    size_t slot_size;
+    int slot;
+    char *_mapped;
+    GLsync _fences[UPLOAD_RING_SLOTS];
+    /**
+     * Waits until the next slot is free, growing the slots to at least size bytes, and returns where to write.
+     * The buffer is left bound to target, offset is where the slot starts in it.
+    */
+    void *(*begin)(struct upload_ring_t *self, size_t size, size_t *offset);
+    /**
+     * Fences the slot once the commands that read it have been issued, and moves on to the next
+    */
+    void (*end)(struct upload_ring_t *self);
+} upload_ring_t;
+
+upload_ring_t *init_upload_ring(GLenum target, size_t slot_size);
+void destroy_upload_ring(upload_ring_t *self);
+
+#endif
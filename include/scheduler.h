@@ -0,0 +1,54 @@
+#ifndef SCHEDULER_H
+
+#define SCHEDULER_H
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include "utils/std_utils.h"
+
+#define SCHEDULER_MIN_RATE 0.1
+#define SCHEDULER_MAX_RATE 1000000.0
+
+/**
+ * Runs generations at a fixed rate in simulated time, however often frames are drawn.
+ * Each frame gets the generations owed since the last one, as many as fit in the frame's budget.
+ * Generations that don't fit are dropped rather than owed, so a slow board never falls further behind.
+*/
+typedef struct scheduler_t
+{
+    /**
+     * Generations per second asked for, under the frame rate some frames run none
+    */
+    double rate;
+    /**
+     * Seconds per frame the scheduler keeps to, and the part of it generations may take
+    */
+    double frame_duration;
+    double budget;
+    /**
+     * Most generations a frame may run. Cut whenever frames overrun, which also catches work
+     * the clock can't see while it runs, such as a GPU board queueing dispatches
+    */
+    int limit;
+    /**
+     * Generations per second actually run, measured about once a second
+    */
+    double achieved;
+    long generations;
+    double _owed;
+    int _ran;
+    double _window;
+    long _window_generations;
+    void (*set_rate)(struct scheduler_t *self, double rate);
+    /**
+     * Runs the generations owed for elapsed seconds through step, returns how many ran
+    */
+    int (*run)(struct scheduler_t *self, double elapsed, void (*step)(void));
+} scheduler_t;
+
+scheduler_t *init_scheduler(double rate, double frame_duration);
+void destroy_scheduler(scheduler_t *self);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SEARCH_H
+
+#define SEARCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "life.h"
+#include "pattern.h"
+#include "utils/std_utils.h"
+#include "utils/thread_utils.h"
+
+// Widest pattern, in either direction, whose dead border still fits a 64 bit word
+#define SEARCH_MAX_SIZE 62
+// Patterns that have not repeated after this many generations are only searched for as given
+#define SEARCH_MAX_PERIOD 64
+
+typedef struct pattern_match_t
+{
+    /**
+     * Index returned by add for the pattern that matched
+    */
+    int pattern;
+    int phase;
+    /**
+     * Quarter turns of the pattern as loaded, plus 4 when it is mirrored first
+    */
+    int orientation;
+    /**
+     * The pattern's live cells on the board, the ring of cells around them is dead
+    */
+    life_bounds_t bounds;
+} pattern_match_t;
+
+typedef struct search_test_t
+{
+    int8_t row;
+    int8_t column;
+    bool alive;
+} search_test_t;
+
+/**
+ * One phase of a pattern in one orientation, as the cells a match has to have alive or dead
+ * relative to the lowest row and column of its bounding box
+*/
+typedef struct search_variant_t
+{
+    int pattern;
+    int phase;
+    int orientation;
+    int rows;
+    int columns;
+    int num_tests;
+    search_test_t *tests;
+} search_variant_t;
+
+/**
+ * A set of small patterns compiled, with all their phases, rotations and reflections, into bit tests
+ * run against a bit packed copy of the board. Each test covers 64 candidate columns at once.
+*/
+typedef struct search_t
+{
+    int num_patterns;
+    int num_variants;
+    search_variant_t *_variants;
+    int _max_rows;
+    /**
+     * Threads find() splits the board's rows between, defaults to one per core
+    */
+    int num_threads;
+    // Bit packed rows of the board with a dead word on both ends and a dead row above and below, reused between searches
+    uint64_t *_packed;
+    size_t _packed_size;
+    int _words;
+    /**
+     * Compiles the pattern and returns the index its matches are reported with
+    */
+    int (*add)(struct search_t *self, pattern_t *pattern);
+    /**
+     * Every occurrence of every pattern on the board's current generation, ordered by row.
+     * The caller frees the returned array.
+    */
+    pattern_match_t *(*find)(struct search_t *self, life_t *life, size_t *num_matches);
+} search_t;
+
+search_t *init_search(void);
+void destroy_search(search_t *self);
+
+#endif
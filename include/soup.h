@@ -0,0 +1,60 @@
+#ifndef SOUP_H
+
+#define SOUP_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "census.h"
+#include "life.h"
+#include "utils/std_utils.h"
+#include "utils/string_utils.h"
+#include "utils/thread_utils.h"
+
+/**
+ * Runs random soups on a torus until they settle and tallies the objects left over.
+ * Soup n is always filled from the same random stream for a given seed, whichever thread runs it.
+*/
+typedef struct soup_search_t
+{
+    int soup_size;
+    /**
+     * Side of the square torus each soup is placed in the middle of
+    */
+    int board_size;
+    uint64_t seed;
+    /**
+     * Soups still changing after this many generations are tallied as they are
+    */
+    long max_generations;
+    int num_threads;
+    /**
+     * The tallies are rewritten to output_file every report_interval soups and when the run ends
+    */
+    long report_interval;
+    const char *output_file;
+    long soups;
+    long generations;
+    census_t *census;
+    /**
+     * Objects of each census species over every soup so far, indexed like census->species
+    */
+    long *tallies;
+    int _num_tallies;
+    long _next_soup;
+    long _last_soup;
+    pthread_mutex_t _lock;
+    void (*run)(struct soup_search_t *self, long num_soups);
+} soup_search_t;
+
+soup_search_t *init_soup_search(const char *output_file);
+/**
+ * Writes the species' code in extended Wechsler format, a strip of 5 rows at a time with each column as one digit.
+ * The phase and orientation written are the census's own pick, so codes need not match other tools'.
+*/
+void write_species_code(FILE *file, const census_species_t *species);
+void destroy_soup_search(soup_search_t *self);
+
+#endif
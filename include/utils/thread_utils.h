@@ -0,0 +1,15 @@
+#ifndef THREAD_UTILS_H
+#define THREAD_UTILS_H
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "utils/std_utils.h"
+
+int get_num_threads(void);
+/**
+ * Runs task on its own thread for each of the count items packed in args, then waits for all of them
+*/
+void run_threads(void *(*task)(void *), void *args, size_t arg_size, int count);
+
+#endif
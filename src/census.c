@@ -0,0 +1,656 @@
+#include "census.h"
+
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME 1099511628211ULL
+
+/**
+ * Columns first through last of a row, all alive, with dead cells on both sides
+*/
+typedef struct census_run_t {
+    int row;
+    int first;
+    int last;
+} census_run_t;
+
+typedef struct census_pass_t {
+    life_t *life;
+    life_bounds_t bounds;
+    census_run_t *runs;
+    /**
+     * Union-find over the runs: parents joins touching runs into pieces, groups joins runs close enough to
+     * change each other's next generation, at most 2 cells apart, into groups of pieces
+    */
+    int *parents;
+    int *groups;
+    // Runs of board row min_x + i are runs[row_starts[i]] up to runs[row_starts[i + 1]]
+    size_t *row_starts;
+    size_t num_pieces;
+    census_object_t *pieces;
+    // The runs of piece i are runs[order[piece_starts[i]]] up to runs[order[piece_starts[i + 1] - 1]]
+    size_t *piece_starts;
+    size_t *order;
+    // Pieces of a group that did not repeat on their own
+    size_t *rest;
+} census_pass_t;
+
+typedef struct census_band_t {
+    census_pass_t *pass;
+    int first_row;
+    int last_row;
+    census_run_t *runs;
+    size_t num_runs;
+    size_t capacity;
+} census_band_t;
+
+static void *find_runs(void *arg) {
+    census_band_t *band = (census_band_t *)arg;
+    life_t *life = band->pass->life;
+    life_bounds_t bounds = band->pass->bounds;
+
+    for (int i = band->first_row; i < band->last_row; i++) {
+        const bool *row = life->grid[i];
+        int j = bounds.min_y;
+
+        while (j <= bounds.max_y) {
+            const bool *start = (const bool *)memchr(row + j, true, bounds.max_y - j + 1);
+            if (start == NULL)
+                break;
+
+            int first = start - row;
+            for (j = first; j <= bounds.max_y && row[j]; j++)
+                ;
+
+            if (band->num_runs == band->capacity) {
+                band->capacity = band->capacity > 0 ? band->capacity * 2 : 256;
+                band->runs = (census_run_t *)realloc(band->runs, band->capacity * sizeof(census_run_t));
+                if (band->runs == NULL) {
+                    error("Unable to allocate memory for census");
+                }
+            }
+
+            band->runs[band->num_runs++] = (census_run_t){i, first, j - 1};
+        }
+    }
+
+    return NULL;
+}
+
+static int find_root(int *parents, int i) {
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+
+    return i;
+}
+
+/**
+ * The lower index becomes the root, so every object's root is its first run
+*/
+static void join(int *parents, int a, int b) {
+    a = find_root(parents, a);
+    b = find_root(parents, b);
+
+    if (a < b)
+        parents[b] = a;
+    else if (b < a)
+        parents[a] = b;
+}
+
+/**
+ * Joins the runs of row x to the runs of row x - distance that come within reach columns of them
+*/
+static void join_runs(census_pass_t *pass, int *parents, int x, int distance, int reach) {
+    if (x - distance < pass->bounds.min_x)
+        return;
+
+    size_t offset = x - pass->bounds.min_x;
+    size_t below = pass->row_starts[offset - distance], below_end = pass->row_starts[offset - distance + 1];
+    const census_run_t *runs = pass->runs;
+
+    for (size_t a = pass->row_starts[offset]; a < pass->row_starts[offset + 1]; a++) {
+        while (below < below_end && runs[below].last + reach < runs[a].first)
+            below++;
+
+        for (size_t b = below; b < below_end && runs[b].first <= runs[a].last + reach; b++)
+            join(parents, a, b);
+    }
+}
+
+/**
+ * Joins the runs of row x to the runs of the rows before it, into pieces where they touch, diagonally
+ * included, and into groups where they are at most 2 cells apart
+*/
+static void join_rows(census_pass_t *pass, int x) {
+    size_t offset = x - pass->bounds.min_x;
+    const census_run_t *runs = pass->runs;
+
+    join_runs(pass, pass->parents, x, 1, 1);
+    join_runs(pass, pass->groups, x, 1, 2);
+    join_runs(pass, pass->groups, x, 2, 2);
+
+    // Runs of one row are at least a dead cell apart, so only those with exactly one between them join
+    for (size_t a = pass->row_starts[offset] + 1; a < pass->row_starts[offset + 1]; a++)
+        if (runs[a].first == runs[a - 1].last + 2)
+            join(pass->groups, a - 1, a);
+}
+
+static void *join_band(void *arg) {
+    census_band_t *band = (census_band_t *)arg;
+
+    // Bands only join their own runs, the first two rows of each band reach back into the band before and are joined afterwards
+    for (int i = band->first_row + 2; i < band->last_row; i++)
+        join_rows(band->pass, i);
+
+    return NULL;
+}
+
+/**
+ * Numbers the roots in the order of their first run and gives every run the number of its root.
+ * A run's parent always comes before it, so its number is known by the time the run is reached.
+*/
+static size_t label_runs(int *parents, size_t num_runs) {
+    size_t num_labels = 0;
+
+    for (size_t i = 0; i < num_runs; i++)
+        parents[i] = parents[i] == (int)i ? (int)num_labels++ : parents[parents[i]];
+
+    return num_labels;
+}
+
+static uint64_t hash_shape(int rows, int columns, const bool *cells) {
+    uint64_t hash = FNV_OFFSET;
+
+    hash = (hash ^ (uint64_t)rows) * FNV_PRIME;
+    hash = (hash ^ (uint64_t)columns) * FNV_PRIME;
+    for (size_t i = 0; i < (size_t)rows * columns; i++)
+        hash = (hash ^ cells[i]) * FNV_PRIME;
+
+    return hash;
+}
+
+static int compare_shapes(int rows, int columns, const bool *cells, int other_rows, int other_columns, const bool *other_cells) {
+    if (rows != other_rows)
+        return rows < other_rows ? -1 : 1;
+    if (columns != other_columns)
+        return columns < other_columns ? -1 : 1;
+
+    return memcmp(cells, other_cells, (size_t)rows * columns);
+}
+
+static census_shape_t *lookup_shape(census_t *self, int rows, int columns, const bool *cells, uint64_t hash) {
+    size_t mask = self->_shapes_capacity - 1;
+
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        census_shape_t *shape = &self->_shapes[i];
+
+        if (shape->cells == NULL ||
+            (shape->hash == hash && compare_shapes(rows, columns, cells, shape->rows, shape->columns, shape->cells) == 0))
+        {
+            return shape;
+        }
+    }
+}
+
+static void insert_shape(census_t *self, census_shape_t shape) {
+    // Kept at most half full so probes stay short
+    if ((self->_num_shapes + 1) * 2 > self->_shapes_capacity) {
+        census_shape_t *shapes = self->_shapes;
+        size_t capacity = self->_shapes_capacity;
+
+        self->_shapes_capacity = capacity > 0 ? capacity * 2 : 1024;
+        self->_shapes = (census_shape_t *)calloc(self->_shapes_capacity, sizeof(census_shape_t));
+        if (self->_shapes == NULL) {
+            error("Unable to allocate memory for census");
+        }
+
+        for (size_t i = 0; i < capacity; i++)
+            if (shapes[i].cells != NULL)
+                *lookup_shape(self, shapes[i].rows, shapes[i].columns, shapes[i].cells, shapes[i].hash) = shapes[i];
+
+        free(shapes);
+    }
+
+    census_shape_t *slot = lookup_shape(self, shape.rows, shape.columns, shape.cells, shape.hash);
+
+    if (slot->cells != NULL) {
+        free(shape.cells);
+        return;
+    }
+
+    *slot = shape;
+    self->_num_shapes++;
+}
+
+static bool *capture_cells(life_t *life) {
+    life_bounds_t bounds = life->bounds;
+    int columns = bounds.max_y - bounds.min_y + 1;
+    bool *cells = (bool *)malloc((size_t)(bounds.max_x - bounds.min_x + 1) * columns * sizeof(bool));
+
+    if (cells == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    for (int i = bounds.min_x; i <= bounds.max_x; i++)
+        memcpy(&cells[(size_t)(i - bounds.min_x) * columns], life->grid[i] + bounds.min_y, columns);
+
+    return cells;
+}
+
+static bool *transform_cells(int rows, int columns, const bool *cells, int orientation) {
+    bool turned = orientation % 2 == 1;
+    int result_columns = turned ? rows : columns;
+    bool *result = (bool *)malloc((size_t)rows * columns * sizeof(bool));
+
+    if (result == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < columns; j++) {
+            int r = i, c = orientation >= 4 ? columns - 1 - j : j;
+            int box_rows = rows, box_columns = columns;
+
+            for (int turn = 0; turn < orientation % 4; turn++) {
+                int tmp = r;
+                r = c;
+                c = box_rows - 1 - tmp;
+                tmp = box_rows;
+                box_rows = box_columns;
+                box_columns = tmp;
+            }
+
+            result[(size_t)r * result_columns + c] = cells[(size_t)i * columns + j];
+        }
+    }
+
+    return result;
+}
+
+static int add_species(census_t *self, census_species_t species) {
+    census_species_t *all = (census_species_t *)realloc(self->species, (self->num_species + 1) * sizeof(census_species_t));
+    if (all == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    self->species = all;
+    self->species[self->num_species] = species;
+
+    return self->num_species++;
+}
+
+/**
+ * Finds the species among the phases of an object, using the phase and orientation that sorts first
+*/
+static int find_species(census_t *self, census_kind_e kind, int period, census_shape_t *phases) {
+    census_species_t best = {kind, period, 0, 0, NULL, 0, 0};
+
+    for (int phase = 0; phase < period; phase++) {
+        for (int orientation = 0; orientation < 8; orientation++) {
+            census_shape_t *shape = &phases[phase];
+            bool turned = orientation % 2 == 1;
+            int rows = turned ? shape->columns : shape->rows, columns = turned ? shape->rows : shape->columns;
+            bool *cells = transform_cells(shape->rows, shape->columns, shape->cells, orientation);
+
+            if (best.cells == NULL || compare_shapes(rows, columns, cells, best.rows, best.columns, best.cells) < 0) {
+                free(best.cells);
+                best.rows = rows;
+                best.columns = columns;
+                best.cells = cells;
+            } else {
+                free(cells);
+            }
+        }
+    }
+
+    for (int i = 0; i < self->num_species; i++) {
+        census_species_t *species = &self->species[i];
+
+        if (species->cells != NULL && compare_shapes(best.rows, best.columns, best.cells, species->rows, species->columns, species->cells) == 0) {
+            free(best.cells);
+            return i;
+        }
+    }
+
+    for (size_t i = 0; i < (size_t)best.rows * best.columns; i++)
+        best.population += best.cells[i];
+
+    return add_species(self, best);
+}
+
+/**
+ * Follows the shape on a board of its own until it repeats, then caches every phase it went through
+*/
+static void classify(census_t *self, census_shape_t *shape) {
+    life_t *scratch = init_life(shape->rows + 2, shape->columns + 2);
+    census_shape_t phases[CENSUS_MAX_PERIOD];
+    int num_phases = 1, period = 0;
+
+    scratch->auto_grow = true;
+    for (int i = 0; i < shape->rows; i++)
+        memcpy(scratch->grid[i + 1] + 1, &shape->cells[(size_t)i * shape->columns], shape->columns);
+    scratch->refresh(scratch);
+
+    phases[0] = *shape;
+    phases[0].cells = capture_cells(scratch);
+
+    int x = scratch->bounds.min_x - scratch->origin_x, y = scratch->bounds.min_y - scratch->origin_y;
+
+    for (int generation = 1; generation <= CENSUS_MAX_PERIOD; generation++) {
+        scratch->live(scratch);
+
+        life_bounds_t bounds = scratch->bounds;
+        if (bounds_empty(bounds))
+            break;
+
+        int rows = bounds.max_x - bounds.min_x + 1, columns = bounds.max_y - bounds.min_y + 1;
+        bool *cells = capture_cells(scratch);
+
+        if (compare_shapes(rows, columns, cells, shape->rows, shape->columns, shape->cells) == 0) {
+            free(cells);
+            period = generation;
+            break;
+        }
+
+        if (num_phases < CENSUS_MAX_PERIOD)
+            phases[num_phases++] = (census_shape_t){rows, columns, cells, hash_shape(rows, columns, cells), 0, 0, 0};
+        else
+            free(cells);
+    }
+
+    if (period == 0) {
+        for (int phase = 1; phase < num_phases; phase++)
+            free(phases[phase].cells);
+
+        // Cached too, a group's pieces are tried on their own before they are tried together
+        phases[0].species = self->_unclassified;
+        phases[0].dx = 0;
+        phases[0].dy = 0;
+        insert_shape(self, phases[0]);
+
+        shape->species = self->_unclassified;
+        shape->dx = 0;
+        shape->dy = 0;
+        destroy_life(scratch);
+        return;
+    }
+
+    int dx = scratch->bounds.min_x - scratch->origin_x - x, dy = scratch->bounds.min_y - scratch->origin_y - y;
+    census_kind_e kind = period == 1 ? census_still_life : dx != 0 || dy != 0 ? census_spaceship : census_oscillator;
+    int species = find_species(self, kind, period, phases);
+
+    // Every phase moves the same distance each period
+    for (int phase = 0; phase < period; phase++) {
+        phases[phase].species = species;
+        phases[phase].dx = dx;
+        phases[phase].dy = dy;
+        insert_shape(self, phases[phase]);
+    }
+
+    shape->species = species;
+    shape->dx = dx;
+    shape->dy = dy;
+    destroy_life(scratch);
+}
+
+/**
+ * Classifies the given pieces as one object, from the shape cache when their cells were seen before
+*/
+static census_object_t identify(census_t *self, census_pass_t *pass, const size_t *members, size_t count) {
+    census_object_t object = {{0, 0, -1, -1}, 0, self->_unclassified, 0, 0};
+
+    for (size_t i = 0; i < count; i++) {
+        object.bounds = bounds_union(object.bounds, pass->pieces[members[i]].bounds);
+        object.population += pass->pieces[members[i]].population;
+    }
+
+    int shape_rows = object.bounds.max_x - object.bounds.min_x + 1;
+    int shape_columns = object.bounds.max_y - object.bounds.min_y + 1;
+
+    if ((long)shape_rows * shape_columns > CENSUS_MAX_AREA)
+        return object;
+
+    bool *cells = (bool *)calloc((size_t)shape_rows * shape_columns, sizeof(bool));
+    if (cells == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t k = pass->piece_starts[members[i]]; k < pass->piece_starts[members[i] + 1]; k++) {
+            census_run_t *run = &pass->runs[pass->order[k]];
+            memset(&cells[(size_t)(run->row - object.bounds.min_x) * shape_columns + run->first - object.bounds.min_y], true, run->last - run->first + 1);
+        }
+    }
+
+    census_shape_t shape = {shape_rows, shape_columns, cells, hash_shape(shape_rows, shape_columns, cells), 0, 0, 0};
+    census_shape_t *cached = self->_shapes_capacity > 0 ? lookup_shape(self, shape_rows, shape_columns, cells, shape.hash) : NULL;
+
+    if (cached != NULL && cached->cells != NULL)
+        shape = (census_shape_t){shape_rows, shape_columns, cells, shape.hash, cached->species, cached->dx, cached->dy};
+    else
+        classify(self, &shape);
+
+    object.species = shape.species;
+    object.dx = shape.dx;
+    object.dy = shape.dy;
+    free(cells);
+
+    return object;
+}
+
+/**
+ * Pieces that repeat on their own are objects by themselves. The rest are classified together, since some
+ * oscillators fall apart on some phases, like a toad into its two halves. Failing that the whole group is
+ * tried, and failing that too the pieces are objects of their own after all.
+*/
+static void take_group(census_t *self, census_pass_t *pass, const size_t *members, size_t count) {
+    size_t first_object = self->num_objects, num_rest = 0;
+    census_object_t object;
+
+    if (count == 1) {
+        self->objects[self->num_objects++] = identify(self, pass, members, 1);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        object = identify(self, pass, &members[i], 1);
+
+        if (object.species != self->_unclassified)
+            self->objects[self->num_objects++] = object;
+        else
+            pass->rest[num_rest++] = members[i];
+    }
+
+    if (num_rest == 0)
+        return;
+
+    if (num_rest > 1) {
+        object = identify(self, pass, pass->rest, num_rest);
+
+        if (object.species != self->_unclassified) {
+            self->objects[self->num_objects++] = object;
+            return;
+        }
+    }
+
+    if (num_rest < count) {
+        object = identify(self, pass, members, count);
+
+        if (object.species != self->_unclassified) {
+            self->num_objects = first_object;
+            self->objects[self->num_objects++] = object;
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < num_rest; i++)
+        self->objects[self->num_objects++] = identify(self, pass, &pass->rest[i], 1);
+}
+
+static void take(census_t *self, life_t *life) {
+    if (life->grid == NULL) {
+        error("A census needs a board held in memory");
+    }
+
+    for (int i = 0; i < self->num_species; i++)
+        self->species[i].count = 0;
+
+    self->num_objects = 0;
+
+    life_bounds_t bounds = life->bounds;
+    if (bounds_empty(bounds))
+        return;
+
+    census_pass_t pass = {.life = life, .bounds = bounds};
+    int rows = bounds.max_x - bounds.min_x + 1;
+    int num_threads = self->num_threads < rows ? self->num_threads : rows;
+
+    census_band_t *bands = (census_band_t *)calloc(num_threads, sizeof(census_band_t));
+    pass.row_starts = (size_t *)calloc(rows + 1, sizeof(size_t));
+    if (bands == NULL || pass.row_starts == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        bands[i].pass = &pass;
+        bands[i].first_row = bounds.min_x + (int)((long)rows * i / num_threads);
+        bands[i].last_row = bounds.min_x + (int)((long)rows * (i + 1) / num_threads);
+    }
+
+    run_threads(find_runs, bands, sizeof(census_band_t), num_threads);
+
+    size_t num_runs = 0;
+    for (int i = 0; i < num_threads; i++)
+        num_runs += bands[i].num_runs;
+
+    pass.runs = (census_run_t *)malloc(num_runs * sizeof(census_run_t));
+    pass.parents = (int *)malloc(num_runs * sizeof(int));
+    pass.groups = (int *)malloc(num_runs * sizeof(int));
+    if (pass.runs == NULL || pass.parents == NULL || pass.groups == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < num_threads; i++) {
+        memcpy(pass.runs + offset, bands[i].runs, bands[i].num_runs * sizeof(census_run_t));
+        offset += bands[i].num_runs;
+        free(bands[i].runs);
+    }
+
+    for (size_t i = 0; i < num_runs; i++) {
+        pass.parents[i] = i;
+        pass.groups[i] = i;
+        pass.row_starts[pass.runs[i].row - bounds.min_x + 1]++;
+    }
+    for (int i = 0; i < rows; i++)
+        pass.row_starts[i + 1] += pass.row_starts[i];
+
+    run_threads(join_band, bands, sizeof(census_band_t), num_threads);
+
+    for (int i = 0; i < num_threads; i++)
+        for (int x = bands[i].first_row; x < bands[i].first_row + 2 && x < bands[i].last_row; x++)
+            join_rows(&pass, x);
+
+    // Pieces and groups are both numbered in the order of their first run
+    int *piece_labels = pass.parents, *group_labels = pass.groups;
+    size_t num_pieces = label_runs(piece_labels, num_runs);
+    size_t num_groups = label_runs(group_labels, num_runs);
+
+    pass.num_pieces = num_pieces;
+    pass.pieces = (census_object_t *)malloc(num_pieces * sizeof(census_object_t));
+    pass.piece_starts = (size_t *)calloc(num_pieces + 1, sizeof(size_t));
+    pass.order = (size_t *)malloc(num_runs * sizeof(size_t));
+    pass.rest = (size_t *)malloc(num_pieces * sizeof(size_t));
+    if (pass.pieces == NULL || pass.piece_starts == NULL || pass.order == NULL || pass.rest == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    for (size_t i = 0; i < num_pieces; i++)
+        pass.pieces[i] = (census_object_t){{0, 0, -1, -1}, 0, self->_unclassified, 0, 0};
+
+    // Order the runs by piece so each piece's cells can be gathered
+    for (size_t i = 0; i < num_runs; i++) {
+        census_run_t *run = &pass.runs[i];
+        census_object_t *piece = &pass.pieces[piece_labels[i]];
+
+        piece->bounds = bounds_union(piece->bounds, (life_bounds_t){run->row, run->first, run->row, run->last});
+        piece->population += run->last - run->first + 1;
+        pass.piece_starts[piece_labels[i] + 1]++;
+    }
+    for (size_t i = 0; i < num_pieces; i++)
+        pass.piece_starts[i + 1] += pass.piece_starts[i];
+    for (size_t i = 0; i < num_runs; i++)
+        pass.order[pass.piece_starts[piece_labels[i]]++] = i;
+    for (size_t i = num_pieces; i > 0; i--)
+        pass.piece_starts[i] = pass.piece_starts[i - 1];
+    pass.piece_starts[0] = 0;
+
+    // Order the pieces by group the same way, a piece's group is the group of any of its runs
+    size_t *group_starts = (size_t *)calloc(num_groups + 1, sizeof(size_t));
+    size_t *members = (size_t *)malloc(num_pieces * sizeof(size_t));
+    if (group_starts == NULL || members == NULL) {
+        error("Unable to allocate memory for census");
+    }
+
+    for (size_t i = 0; i < num_pieces; i++)
+        group_starts[group_labels[pass.order[pass.piece_starts[i]]] + 1]++;
+    for (size_t i = 0; i < num_groups; i++)
+        group_starts[i + 1] += group_starts[i];
+    for (size_t i = 0; i < num_pieces; i++)
+        members[group_starts[group_labels[pass.order[pass.piece_starts[i]]]]++] = i;
+    for (size_t i = num_groups; i > 0; i--)
+        group_starts[i] = group_starts[i - 1];
+    group_starts[0] = 0;
+
+    // There are never more objects than pieces
+    census_object_t *objects = (census_object_t *)realloc(self->objects, (num_pieces > 0 ? num_pieces : 1) * sizeof(census_object_t));
+    if (objects == NULL) {
+        error("Unable to allocate memory for census");
+    }
+    self->objects = objects;
+
+    for (size_t i = 0; i < num_groups; i++)
+        take_group(self, &pass, &members[group_starts[i]], group_starts[i + 1] - group_starts[i]);
+
+    for (size_t i = 0; i < self->num_objects; i++)
+        self->species[self->objects[i].species].count++;
+
+    free(group_starts);
+    free(members);
+    free(pass.pieces);
+    free(pass.piece_starts);
+    free(pass.order);
+    free(pass.rest);
+    free(pass.runs);
+    free(pass.parents);
+    free(pass.groups);
+    free(pass.row_starts);
+    free(bands);
+}
+
+census_t *init_census(void) {
+    census_t *self;
+    self = (census_t *)calloc(1, sizeof(census_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for census.");
+    }
+
+    self->num_threads = get_num_threads();
+    self->take = take;
+    self->_unclassified = add_species(self, (census_species_t){census_unclassified, 0, 0, 0, NULL, 0, 0});
+
+    return self;
+}
+
+void destroy_census(census_t *self) {
+    for (int i = 0; i < self->num_species; i++)
+        free(self->species[i].cells);
+
+    for (size_t i = 0; i < self->_shapes_capacity; i++)
+        free(self->_shapes[i].cells);
+
+    free(self->species);
+    free(self->objects);
+    free(self->_shapes);
+    free(self);
+}
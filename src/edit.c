@@ -0,0 +1,320 @@
+#include "life.h"
+#include <pthread.h>
+
+#define WORD_BITS 64
+
+typedef enum {
+    stamp_edit,
+    fill_edit,
+    points_edit,
+} edit_kind_e;
+
+/**
+ * An edit held back while a generation is computed, with its own copy of the cells or points
+*/
+typedef struct queued_edit_t {
+    edit_kind_e kind;
+    life_edit_op_e op;
+    int x;
+    int y;
+    int orientation;
+    life_bounds_t area;
+    bool alive;
+    life_bits_t *bits;
+    int *points;
+    size_t count;
+} queued_edit_t;
+
+typedef struct edits_t {
+    pthread_mutex_t lock;
+    bool living;
+    queued_edit_t *queue;
+    size_t queued;
+    size_t capacity;
+    // A row of live cells as wide as the board, for fills
+    uint64_t *ones;
+    int ones_words;
+} edits_t;
+
+static inline bool get_bit(const life_bits_t *bits, int row, int column) {
+    return (bits->bits[(size_t)row * bits->words + column / WORD_BITS] >> (column % WORD_BITS)) & 1;
+}
+
+static inline void set_bit(life_bits_t *bits, int row, int column) {
+    bits->bits[(size_t)row * bits->words + column / WORD_BITS] |= (uint64_t)1 << (column % WORD_BITS);
+}
+
+life_bits_t *init_bits(int rows, int columns) {
+    life_bits_t *self;
+    self = (life_bits_t *)calloc(1, sizeof(life_bits_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for packed cells.");
+    }
+
+    self->rows = rows;
+    self->columns = columns;
+    self->words = (columns + WORD_BITS - 1) / WORD_BITS;
+    self->bits = (uint64_t *)calloc((size_t)rows * self->words + 1, sizeof(uint64_t));
+    if (self->bits == NULL) {
+        error("Unable to allocate memory for packed cells.");
+    }
+
+    return self;
+}
+
+life_bits_t *pack_life(life_t *life, life_bounds_t area) {
+    area = bounds_intersect(area, (life_bounds_t){0, 0, life->rows - 1, life->columns - 1});
+    if (bounds_empty(area))
+        return init_bits(0, 0);
+
+    life_bits_t *self = init_bits(area.max_x - area.min_x + 1, area.max_y - area.min_y + 1);
+
+    for (int i = 0; i < self->rows; i++)
+        for (int j = 0; j < self->columns; j++)
+            if (life->get_alive(life, area.min_x + i, area.min_y + j))
+                set_bit(self, i, j);
+
+    return self;
+}
+
+void destroy_bits(life_bits_t *self) {
+    free(self->bits);
+    free(self);
+}
+
+static life_bits_t *copy_bits(const life_bits_t *bits) {
+    life_bits_t *copy = init_bits(bits->rows, bits->columns);
+    memcpy(copy->bits, bits->bits, (size_t)bits->rows * bits->words * sizeof(uint64_t));
+    return copy;
+}
+
+/**
+ * A quarter turn sends (r, c) in a rows x columns box to (c, rows - 1 - r)
+*/
+static life_bits_t *turn_bits(const life_bits_t *bits, int orientation) {
+    bool turned = orientation % 2 == 1;
+    life_bits_t *result = init_bits(turned ? bits->columns : bits->rows, turned ? bits->rows : bits->columns);
+
+    for (int i = 0; i < bits->rows; i++) {
+        for (int j = 0; j < bits->columns; j++) {
+            if (!get_bit(bits, i, j))
+                continue;
+
+            int r = i, c = orientation >= 4 ? bits->columns - 1 - j : j;
+            int rows = bits->rows, columns = bits->columns;
+
+            for (int turn = 0; turn < orientation % 4; turn++) {
+                int tmp = r;
+                r = c;
+                c = rows - 1 - tmp;
+                tmp = rows;
+                rows = columns;
+                columns = tmp;
+            }
+
+            set_bit(result, r, c);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Applies count cells starting at bit offset of row to board row x from column y, clipped to the board
+*/
+static void edit_row(life_t *self, int x, int y, const uint64_t *row, int offset, int count, life_edit_op_e op) {
+    if (x < 0 || x >= self->rows)
+        return;
+
+    if (y < 0) {
+        offset -= y;
+        count += y;
+        y = 0;
+    }
+    if (y + count > self->columns)
+        count = self->columns - y;
+
+    if (count > 0)
+        self->_edit_row(self, x, y, row, offset, count, op);
+}
+
+static void apply_stamp(life_t *self, const life_bits_t *bits, int x, int y, int orientation, life_edit_op_e op) {
+    life_bits_t *turned = orientation % 8 != 0 ? turn_bits(bits, orientation % 8) : NULL;
+    const life_bits_t *cells = turned != NULL ? turned : bits;
+
+    for (int i = 0; i < cells->rows; i++)
+        edit_row(self, x + i, y, cells->bits + (size_t)i * cells->words, 0, cells->columns, op);
+
+    if (op != life_and_not)
+        self->bounds = bounds_union(self->bounds, bounds_intersect(
+            (life_bounds_t){x, y, x + cells->rows - 1, y + cells->columns - 1},
+            (life_bounds_t){0, 0, self->rows - 1, self->columns - 1}
+        ));
+
+    if (turned != NULL)
+        destroy_bits(turned);
+}
+
+static void apply_fill(life_t *self, life_bounds_t area, bool alive) {
+    edits_t *edits = (edits_t *)self->_edits;
+
+    area = bounds_intersect(area, (life_bounds_t){0, 0, self->rows - 1, self->columns - 1});
+    if (bounds_empty(area))
+        return;
+
+    int words = (self->columns + WORD_BITS - 1) / WORD_BITS;
+    if (words > edits->ones_words) {
+        free(edits->ones);
+        edits->ones = (uint64_t *)malloc((words + 1) * sizeof(uint64_t));
+        if (edits->ones == NULL) {
+            error("Unable to allocate memory for board edits");
+        }
+
+        memset(edits->ones, 0xFF, (words + 1) * sizeof(uint64_t));
+        edits->ones_words = words;
+    }
+
+    for (int i = area.min_x; i <= area.max_x; i++)
+        self->_edit_row(self, i, area.min_y, edits->ones, 0, area.max_y - area.min_y + 1, alive ? life_or : life_and_not);
+
+    if (alive)
+        self->bounds = bounds_union(self->bounds, area);
+}
+
+static void apply_points(life_t *self, const int *points, size_t count, life_edit_op_e op) {
+    static const uint64_t one = 1;
+
+    for (size_t i = 0; i < count; i++) {
+        int x = points[i * 2], y = points[i * 2 + 1];
+
+        if (x < 0 || y < 0 || x >= self->rows || y >= self->columns)
+            continue;
+
+        self->_edit_row(self, x, y, &one, 0, 1, op);
+
+        if (op != life_and_not)
+            self->bounds = bounds_union(self->bounds, (life_bounds_t){x, y, x, y});
+    }
+}
+
+static void apply(life_t *self, queued_edit_t *edit) {
+    self->revision++;
+
+    switch (edit->kind) {
+        case stamp_edit:
+            apply_stamp(self, edit->bits, edit->x, edit->y, edit->orientation, edit->op);
+            break;
+        case fill_edit:
+            apply_fill(self, edit->area, edit->alive);
+            break;
+        default:
+            apply_points(self, edit->points, edit->count, edit->op);
+            break;
+    }
+
+    self->stats.density = (double)self->stats.population / ((double)self->rows * self->columns);
+    self->_area_stale = true;
+}
+
+/**
+ * Applies the edit now, or queues a copy of it if a generation is being computed
+*/
+static void submit(life_t *self, queued_edit_t edit) {
+    edits_t *edits = (edits_t *)self->_edits;
+
+    pthread_mutex_lock(&edits->lock);
+
+    if (!edits->living) {
+        apply(self, &edit);
+        pthread_mutex_unlock(&edits->lock);
+        return;
+    }
+
+    if (edits->queued == edits->capacity) {
+        edits->capacity = edits->capacity > 0 ? edits->capacity * 2 : 16;
+        edits->queue = (queued_edit_t *)realloc(edits->queue, edits->capacity * sizeof(queued_edit_t));
+        if (edits->queue == NULL) {
+            error("Unable to allocate memory for board edits");
+        }
+    }
+
+    if (edit.bits != NULL)
+        edit.bits = copy_bits(edit.bits);
+
+    if (edit.points != NULL) {
+        int *points = (int *)malloc(edit.count * 2 * sizeof(int));
+        if (points == NULL) {
+            error("Unable to allocate memory for board edits");
+        }
+
+        memcpy(points, edit.points, edit.count * 2 * sizeof(int));
+        edit.points = points;
+    }
+
+    edits->queue[edits->queued++] = edit;
+    pthread_mutex_unlock(&edits->lock);
+}
+
+static void stamp(life_t *self, const life_bits_t *bits, int x, int y, int orientation, life_edit_op_e op) {
+    submit(self, (queued_edit_t){stamp_edit, op, x, y, orientation, {0, 0, -1, -1}, false, (life_bits_t *)bits, NULL, 0});
+}
+
+static void fill(life_t *self, life_bounds_t area, bool alive) {
+    submit(self, (queued_edit_t){fill_edit, life_or, 0, 0, 0, area, alive, NULL, NULL, 0});
+}
+
+static void edit_points(life_t *self, const int *points, size_t count, life_edit_op_e op) {
+    submit(self, (queued_edit_t){points_edit, op, 0, 0, 0, {0, 0, -1, -1}, false, NULL, (int *)points, count});
+}
+
+void begin_live(life_t *self) {
+    edits_t *edits = (edits_t *)self->_edits;
+
+    pthread_mutex_lock(&edits->lock);
+    edits->living = true;
+    pthread_mutex_unlock(&edits->lock);
+}
+
+void end_live(life_t *self) {
+    edits_t *edits = (edits_t *)self->_edits;
+
+    pthread_mutex_lock(&edits->lock);
+
+    for (size_t i = 0; i < edits->queued; i++) {
+        queued_edit_t *edit = &edits->queue[i];
+
+        apply(self, edit);
+
+        if (edit->bits != NULL)
+            destroy_bits(edit->bits);
+        free(edit->points);
+    }
+
+    edits->queued = 0;
+    edits->living = false;
+
+    pthread_mutex_unlock(&edits->lock);
+}
+
+void init_edits(life_t *self) {
+    edits_t *edits = (edits_t *)calloc(1, sizeof(edits_t));
+    if (edits == NULL) {
+        error("Unable to allocate memory for board edits");
+    }
+
+    pthread_mutex_init(&edits->lock, NULL);
+
+    self->_edits = edits;
+    self->stamp = stamp;
+    self->fill = fill;
+    self->edit_points = edit_points;
+}
+
+void destroy_edits(life_t *self) {
+    edits_t *edits = (edits_t *)self->_edits;
+
+    pthread_mutex_destroy(&edits->lock);
+    free(edits->queue);
+    free(edits->ones);
+    free(edits);
+}
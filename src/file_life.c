@@ -0,0 +1,568 @@
+#include "life.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define WORD_BITS 64
+// Tile revisions take at most this share of the memory budget, boards too big for that track larger tiles
+#define TILE_BUDGET_SHARE 8
+
+#if LIFE_TILE_SIZE != WORD_BITS
+#error "The file backed board assumes tiles are whole words wide"
+#endif
+
+/**
+ * The board lives in a scratch file holding both generations bit packed, one row after another.
+ * live() streams bands of rows through a working set sized from the memory budget, while a helper
+ * thread preads the next band.
+*/
+typedef struct file_life_t {
+    int fd;
+    char *file_name;
+    int words;
+    size_t stride;
+    off_t generation_size;
+    int current;
+    int band_rows;
+    uint64_t *bands[2];
+    uint64_t *output;
+    uint64_t last_word_mask;
+    // Write back cache of a single row of the current generation, for get_alive and set_alive
+    uint64_t *row_cache;
+    int cached_row;
+    bool cache_dirty;
+} file_life_t;
+
+typedef struct band_read_t {
+    file_life_t *engine;
+    int generation;
+    int first_row;
+    int num_rows;
+    int rows;
+    uint64_t *destination;
+} band_read_t;
+
+static void read_rows(file_life_t *engine, int generation, int first_row, int num_rows, int rows, uint64_t *destination) {
+    for (int i = 0; i < num_rows; i++) {
+        int row = first_row + i;
+        char *cursor = (char *)(destination + (size_t)i * engine->words);
+
+        // Rows past the edges of the board are dead
+        if (row < 0 || row >= rows) {
+            memset(cursor, 0, engine->stride);
+            continue;
+        }
+
+        // Read the rest of the band that is on the board in one go
+        int count = 1;
+        while (i + count < num_rows && row + count < rows)
+            count++;
+
+        size_t remaining = engine->stride * count;
+        off_t offset = engine->generation_size * generation + (off_t)engine->stride * row;
+
+        while (remaining > 0) {
+            ssize_t length = pread(engine->fd, cursor, remaining, offset);
+            if (length <= 0)
+                error("Unable to read board from file");
+
+            cursor += length;
+            offset += length;
+            remaining -= length;
+        }
+
+        i += count - 1;
+    }
+}
+
+static void write_rows(file_life_t *engine, int generation, int first_row, int num_rows, const uint64_t *source) {
+    const char *cursor = (const char *)source;
+    size_t remaining = engine->stride * num_rows;
+    off_t offset = engine->generation_size * generation + (off_t)engine->stride * first_row;
+
+    while (remaining > 0) {
+        ssize_t length = pwrite(engine->fd, cursor, remaining, offset);
+        if (length <= 0)
+            error("Unable to write board to file");
+
+        cursor += length;
+        offset += length;
+        remaining -= length;
+    }
+}
+
+static void *read_band(void *arg) {
+    band_read_t *request = (band_read_t *)arg;
+    read_rows(request->engine, request->generation, request->first_row, request->num_rows, request->rows, request->destination);
+    return NULL;
+}
+
+static void flush_row_cache(file_life_t *engine) {
+    if (engine->cache_dirty)
+        write_rows(engine, engine->current, engine->cached_row, 1, engine->row_cache);
+
+    engine->cache_dirty = false;
+}
+
+static uint64_t *load_row(life_t *self, int x) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+
+    if (engine->cached_row != x) {
+        flush_row_cache(engine);
+        read_rows(engine, engine->current, x, 1, self->rows, engine->row_cache);
+        engine->cached_row = x;
+    }
+
+    return engine->row_cache;
+}
+
+static bool get_alive(life_t *self, int x, int y) {
+    uint64_t *row = load_row(self, x);
+    return (row[y / WORD_BITS] >> (y % WORD_BITS)) & 1;
+}
+
+/**
+ * Writes straight into the current generation, there is no shadow copy to write into
+*/
+static void set_alive(life_t *self, int x, int y, bool alive) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+    uint64_t *row = load_row(self, x);
+    uint64_t bit = (uint64_t)1 << (y % WORD_BITS);
+
+    if (((row[y / WORD_BITS] & bit) != 0) != alive) {
+        self->tile_revisions[(size_t)(x / self->tile_size) * self->tile_columns + y / self->tile_size] = ++self->revision;
+        self->stats.population += alive ? 1 : -1;
+    }
+
+    if (alive) {
+        row[y / WORD_BITS] |= bit;
+        self->bounds = bounds_union(self->bounds, (life_bounds_t){x, y, x, y});
+    } else {
+        row[y / WORD_BITS] &= ~bit;
+    }
+
+    engine->cache_dirty = true;
+}
+
+static void pack_row(life_t *self, int x, int first_word, int num_words, uint64_t *bits) {
+    memcpy(bits, load_row(self, x) + first_word, num_words * sizeof(uint64_t));
+}
+
+static inline uint64_t read_bits(const uint64_t *bits, long start) {
+    long index = start / WORD_BITS;
+    int shift = start % WORD_BITS;
+
+    return shift == 0 ? bits[index] : (bits[index] >> shift) | (bits[index + 1] << (WORD_BITS - shift));
+}
+
+/**
+ * Edits the cached row a word at a time, the source bits shifted into line with each board word
+*/
+static void edit_row(life_t *self, int x, int y, const uint64_t *bits, int offset, int count, life_edit_op_e op) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+    uint64_t *row = load_row(self, x);
+    unsigned long *tiles = self->tile_revisions + (size_t)(x / self->tile_size) * self->tile_columns;
+    int words_per_tile = self->tile_size / WORD_BITS;
+    int end = y + count;
+
+    for (int w = y / WORD_BITS; w <= (end - 1) / WORD_BITS; w++) {
+        int first = w * WORD_BITS > y ? w * WORD_BITS : y;
+        int last = (w + 1) * WORD_BITS < end ? (w + 1) * WORD_BITS : end;
+        uint64_t source = w * WORD_BITS >= y ? read_bits(bits, (long)offset + w * WORD_BITS - y) : read_bits(bits, offset) << (y - w * WORD_BITS);
+        uint64_t mask = (~(uint64_t)0 >> (WORD_BITS - (last - first))) << (first - w * WORD_BITS);
+        uint64_t cells = row[w];
+
+        source &= mask;
+        row[w] = op == life_or ? cells | source : op == life_xor ? cells ^ source : cells & ~source;
+
+        if (row[w] != cells) {
+            self->stats.population += __builtin_popcountll(row[w]) - __builtin_popcountll(cells);
+            tiles[w / words_per_tile] = self->revision;
+            engine->cache_dirty = true;
+        }
+    }
+}
+
+static long count_alive(life_t *self, int x0, int y0, int x1, int y1) {
+    life_bounds_t area = bounds_intersect((life_bounds_t){x0, y0, x1, y1}, self->bounds);
+    long count = 0;
+
+    if (bounds_empty(area))
+        return 0;
+
+    int first = area.min_y / WORD_BITS, last = area.max_y / WORD_BITS;
+    uint64_t first_mask = ~(uint64_t)0 << (area.min_y % WORD_BITS);
+    uint64_t last_mask = ~(uint64_t)0 >> (WORD_BITS - 1 - area.max_y % WORD_BITS);
+
+    for (int i = area.min_x; i <= area.max_x; i++) {
+        const uint64_t *row = load_row(self, i);
+
+        if (first == last) {
+            count += __builtin_popcountll(row[first] & first_mask & last_mask);
+            continue;
+        }
+
+        count += __builtin_popcountll(row[first] & first_mask) + __builtin_popcountll(row[last] & last_mask);
+        for (int w = first + 1; w < last; w++)
+            count += __builtin_popcountll(row[w]);
+    }
+
+    return count;
+}
+
+/**
+ * Grows bounds to cover the live cells of a packed row
+*/
+static void include_row(life_bounds_t *bounds, int x, const uint64_t *row, int words) {
+    int first = 0;
+    while (first < words && row[first] == 0)
+        first++;
+
+    if (first == words)
+        return;
+
+    int last = words - 1;
+    while (row[last] == 0)
+        last--;
+
+    int min_y = first * WORD_BITS + __builtin_ctzll(row[first]);
+    int max_y = last * WORD_BITS + (WORD_BITS - 1 - __builtin_clzll(row[last]));
+
+    *bounds = bounds_union(*bounds, (life_bounds_t){x, min_y, x, max_y});
+}
+
+/**
+ * Adds a packed row of the new generation to stats, previous is the same row a generation earlier or NULL
+*/
+static void count_row(life_stats_t *stats, const uint64_t *previous, const uint64_t *row, int words) {
+    for (int w = 0; w < words; w++) {
+        stats->population += __builtin_popcountll(row[w]);
+
+        if (previous != NULL) {
+            stats->births += __builtin_popcountll(row[w] & ~previous[w]);
+            stats->deaths += __builtin_popcountll(previous[w] & ~row[w]);
+        }
+    }
+}
+
+static void update_density(life_t *self) {
+    self->stats.density = (double)self->stats.population / ((double)self->rows * self->columns);
+}
+
+#define FULL_ADD(a, b, c, sum, carry) \
+    {                                 \
+        uint64_t t = (a) ^ (b);       \
+        sum = t ^ (c);                \
+        carry = ((a) & (b)) | (t & (c)); \
+    }
+
+/**
+ * Advances 64 cells at once by adding up their eight neighbors as bit sliced counters
+*/
+static void step_row(const uint64_t *above, const uint64_t *row, const uint64_t *below, uint64_t *out, int words, uint64_t last_word_mask) {
+    for (int w = 0; w < words; w++) {
+        uint64_t a = above[w], b = row[w], c = below[w];
+        uint64_t a_prev = w > 0 ? above[w - 1] : 0, b_prev = w > 0 ? row[w - 1] : 0, c_prev = w > 0 ? below[w - 1] : 0;
+        uint64_t a_next = w + 1 < words ? above[w + 1] : 0, b_next = w + 1 < words ? row[w + 1] : 0, c_next = w + 1 < words ? below[w + 1] : 0;
+
+        // Bit j of a_left holds the cell at j - 1, bit j of a_right the cell at j + 1
+        uint64_t a_left = (a << 1) | (a_prev >> 63), a_right = (a >> 1) | (a_next << 63);
+        uint64_t b_left = (b << 1) | (b_prev >> 63), b_right = (b >> 1) | (b_next << 63);
+        uint64_t c_left = (c << 1) | (c_prev >> 63), c_right = (c >> 1) | (c_next << 63);
+
+        uint64_t sum_a, carry_a, sum_b, carry_b, ones, carry_ones, sum_twos, fours;
+        FULL_ADD(a_left, a, a_right, sum_a, carry_a);
+        FULL_ADD(b_left, b_right, c_left, sum_b, carry_b);
+        uint64_t sum_c = c ^ c_right, carry_c = c & c_right;
+
+        FULL_ADD(sum_a, sum_b, sum_c, ones, carry_ones);
+        FULL_ADD(carry_a, carry_b, carry_c, sum_twos, fours);
+
+        uint64_t twos = sum_twos ^ carry_ones;
+        uint64_t more = fours | (sum_twos & carry_ones);
+
+        // Three neighbors, or two and already alive
+        out[w] = ~more & twos & (ones | b);
+    }
+
+    out[words - 1] &= last_word_mask;
+}
+
+static void swap(life_t *self) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+
+    flush_row_cache(engine);
+    engine->current = 1 - engine->current;
+    engine->cached_row = -1;
+
+    life_bounds_t bounds = self->bounds;
+    self->bounds = self->_shadow_bounds;
+    self->_shadow_bounds = bounds;
+}
+
+/**
+ * Only the bands holding the live rows plus a margin, and the rows still live in the other generation, are streamed
+*/
+static void live(life_t *self) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+    int words = engine->words, words_per_tile = self->tile_size / WORD_BITS;
+    int next = 1 - engine->current;
+
+    // Edits are queued from here on, so the sweep covers every cell they could have touched
+    begin_live(self);
+
+    life_bounds_t sweep = bounds_union(bounds_expand(self->bounds, 1, self->rows, self->columns), self->_shadow_bounds);
+    life_bounds_t next_bounds = {0, 0, -1, -1};
+    life_stats_t stats = {self->stats.generation + 1, 0, 0, 0, 0.0};
+    unsigned long revision = ++self->revision;
+    flush_row_cache(engine);
+
+    if (bounds_empty(sweep)) {
+        self->stats = stats;
+        self->swap(self);
+        end_live(self);
+        return;
+    }
+
+    int end_row = sweep.max_x + 1;
+
+    // Each band is read with the row above and below it so its edges see their neighbors
+    read_rows(engine, engine->current, sweep.min_x - 1, engine->band_rows + 2, self->rows, engine->bands[0]);
+
+    for (int first_row = sweep.min_x, band = 0; first_row < end_row; first_row += engine->band_rows, band++) {
+        int num_rows = end_row - first_row < engine->band_rows ? end_row - first_row : engine->band_rows;
+        int next_first_row = first_row + engine->band_rows;
+        uint64_t *input = engine->bands[band % 2];
+
+        pthread_t prefetch;
+        band_read_t request = {engine, engine->current, next_first_row - 1, engine->band_rows + 2, self->rows, engine->bands[(band + 1) % 2]};
+        bool prefetching = next_first_row < end_row;
+
+        if (prefetching && pthread_create(&prefetch, NULL, read_band, &request) != 0)
+            error("Unable to start prefetch thread");
+
+        for (int i = 0; i < num_rows; i++) {
+            uint64_t *out = engine->output + (size_t)i * words;
+
+            step_row(
+                input + (size_t)i * words,
+                input + (size_t)(i + 1) * words,
+                input + (size_t)(i + 2) * words,
+                out,
+                words,
+                engine->last_word_mask
+            );
+
+            include_row(&next_bounds, first_row + i, out, words);
+            count_row(&stats, input + (size_t)(i + 1) * words, out, words);
+
+            // Tiles are whole words wide
+            const uint64_t *row = input + (size_t)(i + 1) * words;
+            unsigned long *tiles = self->tile_revisions + (size_t)((first_row + i) / self->tile_size) * self->tile_columns;
+            for (int w = 0; w < words; w++)
+                if (out[w] != row[w])
+                    tiles[w / words_per_tile] = revision;
+        }
+
+        write_rows(engine, next, first_row, num_rows, engine->output);
+
+        if (prefetching)
+            pthread_join(prefetch, NULL);
+    }
+
+    // Every live row of the other generation was inside the sweep, so it now holds exactly next_bounds
+    self->_shadow_bounds = next_bounds;
+    self->stats = stats;
+    update_density(self);
+    self->swap(self);
+
+    end_live(self);
+}
+
+static uint64_t random_word() {
+    // rand() only guarantees 15 random bits
+    uint64_t word = 0;
+    for (int i = 0; i < 5; i++)
+        word = (word << 15) ^ (uint64_t)rand();
+
+    return word;
+}
+
+static void seed(life_t *self) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+
+    flush_row_cache(engine);
+    engine->cached_row = -1;
+    self->bounds = (life_bounds_t){0, 0, -1, -1};
+    self->stats.population = 0;
+    self->revision++;
+    reset_tiles(self);
+
+    for (int first_row = 0; first_row < self->rows; first_row += engine->band_rows) {
+        int num_rows = self->rows - first_row < engine->band_rows ? self->rows - first_row : engine->band_rows;
+
+        for (int i = 0; i < num_rows; i++) {
+            uint64_t *row = engine->output + (size_t)i * engine->words;
+
+            for (int w = 0; w < engine->words; w++)
+                row[w] = random_word();
+
+            row[engine->words - 1] &= engine->last_word_mask;
+            include_row(&self->bounds, first_row + i, row, engine->words);
+            count_row(&self->stats, NULL, row, engine->words);
+        }
+
+        write_rows(engine, engine->current, first_row, num_rows, engine->output);
+    }
+
+    self->stats.births = 0;
+    self->stats.deaths = 0;
+    update_density(self);
+}
+
+static void refresh(life_t *self) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+
+    flush_row_cache(engine);
+    self->bounds = (life_bounds_t){0, 0, -1, -1};
+    self->stats.population = 0;
+    self->revision++;
+    reset_tiles(self);
+
+    for (int first_row = 0; first_row < self->rows; first_row += engine->band_rows) {
+        int num_rows = self->rows - first_row < engine->band_rows ? self->rows - first_row : engine->band_rows;
+
+        read_rows(engine, engine->current, first_row, num_rows, self->rows, engine->output);
+
+        for (int i = 0; i < num_rows; i++) {
+            include_row(&self->bounds, first_row + i, engine->output + (size_t)i * engine->words, engine->words);
+            count_row(&self->stats, NULL, engine->output + (size_t)i * engine->words, engine->words);
+        }
+    }
+
+    self->stats.births = 0;
+    self->stats.deaths = 0;
+    update_density(self);
+}
+
+static void print(life_t *self) {
+    for (int i = self->rows - 1; i >= 0; i--) {
+        for (int j = 0; j < self->columns; j++)
+            printf("| %c ", get_alive(self, i, j) ? 'X' : 'O');
+
+        printf("|\n");
+    }
+}
+
+static void print_shadow(life_t *self) {
+    (void)self;
+    error("The file backed board does not keep a shadow grid in memory");
+}
+
+static void destroy(life_t *self) {
+    file_life_t *engine = (file_life_t *)self->_engine;
+
+    close(engine->fd);
+    unlink(engine->file_name);
+
+    free(engine->file_name);
+    free(engine->bands[0]);
+    free(engine->bands[1]);
+    free(engine->output);
+    free(engine->row_cache);
+    free(engine);
+    free(self->tile_revisions);
+    destroy_edits(self);
+    free(self);
+}
+
+static uint64_t *alloc_rows(file_life_t *engine, int num_rows) {
+    uint64_t *rows = (uint64_t *)calloc((size_t)num_rows * engine->words, sizeof(uint64_t));
+    if (rows == NULL) {
+        error("Unable to allocate memory for board band");
+    }
+
+    return rows;
+}
+
+static size_t tile_table_size(int rows, int columns, long tile_size) {
+    return (size_t)((rows + tile_size - 1) / tile_size) * ((columns + tile_size - 1) / tile_size) * sizeof(unsigned long);
+}
+
+life_t *init_file_life(int rows, int columns, const char *file_name, size_t memory_budget) {
+    srand(time(0));
+    life_t *self;
+    file_life_t *engine;
+
+    self = (life_t *)calloc(1, sizeof(life_t));
+    engine = (file_life_t *)calloc(1, sizeof(file_life_t));
+    if (self == NULL || engine == NULL) {
+        error("Unable to allocate memory for life.");
+    }
+
+    self->rows = rows;
+    self->columns = columns;
+    self->_engine = engine;
+
+    engine->words = (columns + WORD_BITS - 1) / WORD_BITS;
+    engine->stride = engine->words * sizeof(uint64_t);
+    engine->generation_size = (off_t)engine->stride * rows;
+    engine->last_word_mask = columns % WORD_BITS == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (columns % WORD_BITS)) - 1;
+    engine->cached_row = -1;
+
+    long tile_size = LIFE_TILE_SIZE;
+    while (tile_size < (rows > columns ? rows : columns) && tile_table_size(rows, columns, tile_size) > memory_budget / TILE_BUDGET_SHARE)
+        tile_size *= 2;
+
+    self->tile_size = tile_size < INT_MAX ? tile_size : INT_MAX / 2 + 1;
+
+    // The tile revisions come out of the budget first, then two input bands of band_rows + 2 rows, one output band and the single cached row
+    size_t tile_table = tile_table_size(rows, columns, self->tile_size);
+    long budget_rows = memory_budget > tile_table ? (memory_budget - tile_table) / engine->stride : 0;
+    engine->band_rows = (budget_rows - 5) / 3;
+
+    if (engine->band_rows < 1)
+        error("Memory budget is too small to hold a band of the board");
+    if (engine->band_rows > rows)
+        engine->band_rows = rows;
+
+    engine->bands[0] = alloc_rows(engine, engine->band_rows + 2);
+    engine->bands[1] = alloc_rows(engine, engine->band_rows + 2);
+    engine->output = alloc_rows(engine, engine->band_rows);
+    engine->row_cache = alloc_rows(engine, 1);
+
+    engine->file_name = strdup(file_name);
+    engine->fd = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (engine->fd == -1) {
+        error(str_concat("Unable to create board file ", file_name));
+    }
+
+    // Sparse until written, both generations start out dead
+    if (ftruncate(engine->fd, engine->generation_size * 2) == -1) {
+        error(str_concat("Unable to size board file ", file_name));
+    }
+
+    posix_fadvise(engine->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    self->print = print;
+    self->print_shadow = print_shadow;
+    self->seed = seed;
+    self->swap = swap;
+    self->set_alive = set_alive;
+    self->get_alive = get_alive;
+    self->live = live;
+    self->refresh = refresh;
+    self->count_alive = count_alive;
+    self->pack_row = pack_row;
+    self->_edit_row = edit_row;
+    self->_destroy = destroy;
+    self->bounds = (life_bounds_t){0, 0, -1, -1};
+    self->_shadow_bounds = self->bounds;
+    reset_tiles(self);
+    init_edits(self);
+
+    return self;
+}
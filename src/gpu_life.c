@@ -0,0 +1,408 @@
+#include "life.h"
+#include <glad/glad.h>
+#include "lib/shader.h"
+
+#define WORD_BITS 64
+// Matches local_size_x and local_size_y of life.comp
+#define GROUP_SIZE 8
+
+#if LIFE_TILE_SIZE != WORD_BITS
+#error "The GPU board assumes tiles are one word wide"
+#endif
+
+/**
+ * Both generations live in R32UI textures on the GPU and a compute shader steps one into the other.
+ * cells is a copy of the current generation read back only when something on the CPU asks for a cell,
+ * and kept in step with the texture by edits until the next generation.
+*/
+typedef struct gpu_life_t {
+    shader_t *shader;
+    unsigned int textures[2];
+    int current;
+    unsigned int stats_buffer;
+    int words;
+    int texels;
+    uint64_t last_word_mask;
+    uint64_t *cells;
+    bool read;
+    // Births and deaths of the last dispatch are waiting in stats_buffer
+    bool counted;
+} gpu_life_t;
+
+static void update_density(life_t *self) {
+    self->stats.density = (double)self->stats.population / ((double)self->rows * self->columns);
+}
+
+/**
+ * Grows bounds to cover the live cells of a packed row
+*/
+static void include_row(life_bounds_t *bounds, int x, const uint64_t *row, int words) {
+    int first = 0;
+    while (first < words && row[first] == 0)
+        first++;
+
+    if (first == words)
+        return;
+
+    int last = words - 1;
+    while (row[last] == 0)
+        last--;
+
+    int min_y = first * WORD_BITS + __builtin_ctzll(row[first]);
+    int max_y = last * WORD_BITS + (WORD_BITS - 1 - __builtin_clzll(row[last]));
+
+    *bounds = bounds_union(*bounds, (life_bounds_t){x, min_y, x, max_y});
+}
+
+static void count_cells(life_t *self) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    self->bounds = (life_bounds_t){0, 0, -1, -1};
+    self->stats.population = 0;
+
+    for (int i = 0; i < self->rows; i++) {
+        const uint64_t *row = engine->cells + (size_t)i * engine->words;
+
+        include_row(&self->bounds, i, row, engine->words);
+        for (int w = 0; w < engine->words; w++)
+            self->stats.population += __builtin_popcountll(row[w]);
+    }
+
+    update_density(self);
+}
+
+/**
+ * The only way cells come back from the GPU. A row of 64 bit words and a row of texels twice as wide are
+ * the same bytes, so the texture is read straight into cells.
+*/
+static void read_back(life_t *self) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    if (engine->read)
+        return;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, engine->textures[engine->current]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, engine->cells);
+
+    count_cells(self);
+
+    if (engine->counted) {
+        uint32_t counts[4];
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, engine->stats_buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), counts);
+
+        self->stats.births = (long)counts[1] << 32 | counts[0];
+        self->stats.deaths = (long)counts[3] << 32 | counts[2];
+        engine->counted = false;
+    }
+
+    engine->read = true;
+}
+
+static void upload_rows(life_t *self, int first_row, int num_rows) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D, engine->textures[engine->current]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first_row, engine->words * 2, num_rows,
+                    GL_RED_INTEGER, GL_UNSIGNED_INT, engine->cells + (size_t)first_row * engine->words);
+}
+
+static bool get_alive(life_t *self, int x, int y) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    read_back(self);
+    return (engine->cells[(size_t)x * engine->words + y / WORD_BITS] >> (y % WORD_BITS)) & 1;
+}
+
+static void set_alive(life_t *self, int x, int y, bool alive) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    read_back(self);
+
+    uint64_t *word = engine->cells + (size_t)x * engine->words + y / WORD_BITS;
+    uint64_t bit = (uint64_t)1 << (y % WORD_BITS);
+
+    if (((*word & bit) != 0) == alive)
+        return;
+
+    *word ^= bit;
+    self->stats.population += alive ? 1 : -1;
+    self->tile_revisions[(size_t)(x / LIFE_TILE_SIZE) * self->tile_columns + y / LIFE_TILE_SIZE] = ++self->revision;
+    update_density(self);
+
+    if (alive)
+        self->bounds = bounds_union(self->bounds, (life_bounds_t){x, y, x, y});
+
+    upload_rows(self, x, 1);
+}
+
+static inline uint64_t read_bits(const uint64_t *bits, long start) {
+    long index = start / WORD_BITS;
+    int shift = start % WORD_BITS;
+
+    return shift == 0 ? bits[index] : (bits[index] >> shift) | (bits[index + 1] << (WORD_BITS - shift));
+}
+
+/**
+ * Edits the copy a word at a time, then uploads the row if it changed
+*/
+static void edit_row(life_t *self, int x, int y, const uint64_t *bits, int offset, int count, life_edit_op_e op) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    read_back(self);
+
+    uint64_t *row = engine->cells + (size_t)x * engine->words;
+    unsigned long *tiles = self->tile_revisions + (size_t)(x / LIFE_TILE_SIZE) * self->tile_columns;
+    int end = y + count;
+    bool changed = false;
+
+    for (int w = y / WORD_BITS; w <= (end - 1) / WORD_BITS; w++) {
+        int first = w * WORD_BITS > y ? w * WORD_BITS : y;
+        int last = (w + 1) * WORD_BITS < end ? (w + 1) * WORD_BITS : end;
+        uint64_t source = w * WORD_BITS >= y ? read_bits(bits, (long)offset + w * WORD_BITS - y) : read_bits(bits, offset) << (y - w * WORD_BITS);
+        uint64_t mask = (~(uint64_t)0 >> (WORD_BITS - (last - first))) << (first - w * WORD_BITS);
+        uint64_t cells = row[w];
+
+        source &= mask;
+        row[w] = op == life_or ? cells | source : op == life_xor ? cells ^ source : cells & ~source;
+
+        if (row[w] != cells) {
+            self->stats.population += __builtin_popcountll(row[w]) - __builtin_popcountll(cells);
+            tiles[w] = self->revision;
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        update_density(self);
+        upload_rows(self, x, 1);
+    }
+}
+
+static long count_alive(life_t *self, int x0, int y0, int x1, int y1) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    read_back(self);
+
+    life_bounds_t area = bounds_intersect((life_bounds_t){x0, y0, x1, y1}, self->bounds);
+    long count = 0;
+
+    if (bounds_empty(area))
+        return 0;
+
+    for (int i = area.min_x; i <= area.max_x; i++) {
+        const uint64_t *row = engine->cells + (size_t)i * engine->words;
+
+        for (int w = area.min_y / WORD_BITS; w <= area.max_y / WORD_BITS; w++) {
+            uint64_t word = row[w];
+
+            if (w == area.min_y / WORD_BITS)
+                word &= ~(uint64_t)0 << (area.min_y % WORD_BITS);
+            if (w == area.max_y / WORD_BITS)
+                word &= ~(uint64_t)0 >> (WORD_BITS - 1 - area.max_y % WORD_BITS);
+
+            count += __builtin_popcountll(word);
+        }
+    }
+
+    return count;
+}
+
+static void pack_row(life_t *self, int x, int first_word, int num_words, uint64_t *bits) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    read_back(self);
+    memcpy(bits, engine->cells + (size_t)x * engine->words + first_word, num_words * sizeof(uint64_t));
+}
+
+static void swap(life_t *self) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    engine->current = 1 - engine->current;
+    engine->read = false;
+    self->texture = engine->textures[engine->current];
+}
+
+/**
+ * Nothing is read back, so bounds cover the whole board and every tile is stamped with the new revision
+*/
+static void live(life_t *self) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+    shader_t *shader = engine->shader;
+    int width = engine->words * 2;
+
+    begin_live(self);
+    self->revision++;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, engine->stats_buffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, engine->stats_buffer);
+    glBindImageTexture(0, engine->textures[engine->current], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindImageTexture(1, engine->textures[1 - engine->current], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+
+    shader->use(shader);
+    glDispatchCompute((width + GROUP_SIZE - 1) / GROUP_SIZE, (self->rows + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+    // Whatever reads the new generation next, drawing, reading it back or the next dispatch
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                    GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    engine->counted = true;
+    self->stats.generation++;
+    self->bounds = (life_bounds_t){0, 0, self->rows - 1, self->columns - 1};
+    reset_tiles(self);
+    self->swap(self);
+
+    end_live(self);
+}
+
+static uint64_t random_word() {
+    // rand() only guarantees 15 random bits
+    uint64_t word = 0;
+    for (int i = 0; i < 5; i++)
+        word = (word << 15) ^ (uint64_t)rand();
+
+    return word;
+}
+
+static void seed(life_t *self) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    for (int i = 0; i < self->rows; i++) {
+        uint64_t *row = engine->cells + (size_t)i * engine->words;
+
+        for (int w = 0; w < engine->words; w++)
+            row[w] = random_word();
+
+        row[engine->words - 1] &= engine->last_word_mask;
+    }
+
+    engine->read = true;
+    engine->counted = false;
+    upload_rows(self, 0, self->rows);
+
+    self->revision++;
+    reset_tiles(self);
+    count_cells(self);
+    self->stats.births = 0;
+    self->stats.deaths = 0;
+}
+
+static void refresh(life_t *self) {
+    read_back(self);
+
+    self->revision++;
+    reset_tiles(self);
+    count_cells(self);
+    self->stats.births = 0;
+    self->stats.deaths = 0;
+}
+
+static void print(life_t *self) {
+    for (int i = self->rows - 1; i >= 0; i--) {
+        for (int j = 0; j < self->columns; j++)
+            printf("| %c ", get_alive(self, i, j) ? 'X' : 'O');
+
+        printf("|\n");
+    }
+}
+
+static void print_shadow(life_t *self) {
+    (void)self;
+    error("The GPU board does not keep a shadow grid in memory");
+}
+
+static void destroy(life_t *self) {
+    gpu_life_t *engine = (gpu_life_t *)self->_engine;
+
+    glDeleteTextures(2, engine->textures);
+    glDeleteBuffers(1, &engine->stats_buffer);
+    glDeleteProgram(engine->shader->ID);
+    destroy_shader(engine->shader);
+
+    free(engine->cells);
+    free(engine);
+    free(self->tile_revisions);
+    destroy_edits(self);
+    free(self);
+}
+
+life_t *init_gpu_life(int rows, int columns) {
+    srand(time(0));
+    life_t *self;
+    gpu_life_t *engine;
+
+    self = (life_t *)calloc(1, sizeof(life_t));
+    engine = (gpu_life_t *)calloc(1, sizeof(gpu_life_t));
+    if (self == NULL || engine == NULL) {
+        error("Unable to allocate memory for life.");
+    }
+
+    self->rows = rows;
+    self->columns = columns;
+    self->_engine = engine;
+
+    engine->words = (columns + WORD_BITS - 1) / WORD_BITS;
+    engine->texels = (columns + 31) / 32;
+    engine->last_word_mask = columns % WORD_BITS == 0 ? ~(uint64_t)0 : ((uint64_t)1 << (columns % WORD_BITS)) - 1;
+    engine->read = true;
+
+    int max_size;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    if (rows > max_size || engine->words * 2 > max_size) {
+        error("The board is too large to fit in a texture");
+    }
+
+    engine->cells = (uint64_t *)calloc((size_t)rows * engine->words, sizeof(uint64_t));
+    if (engine->cells == NULL) {
+        error("Unable to allocate memory for life.");
+    }
+
+    engine->shader = init_compute_shader("life.comp");
+    engine->shader->use(engine->shader);
+    engine->shader->setUniformInt(engine->shader, "rows", rows);
+    engine->shader->setUniformInt(engine->shader, "texels", engine->texels);
+    engine->shader->setUniformInt(engine->shader, "lastColumns", columns % 32);
+
+    glGenTextures(2, engine->textures);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, engine->textures[i]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, engine->words * 2, rows);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    glGenBuffers(1, &engine->stats_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, engine->stats_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 4 * sizeof(uint32_t), NULL, GL_DYNAMIC_READ);
+
+    self->print = print;
+    self->print_shadow = print_shadow;
+    self->seed = seed;
+    self->swap = swap;
+    self->set_alive = set_alive;
+    self->get_alive = get_alive;
+    self->live = live;
+    self->refresh = refresh;
+    self->count_alive = count_alive;
+    self->pack_row = pack_row;
+    self->_edit_row = edit_row;
+    self->_destroy = destroy;
+    self->bounds = (life_bounds_t){0, 0, -1, -1};
+    self->_shadow_bounds = self->bounds;
+    self->texture = engine->textures[engine->current];
+    reset_tiles(self);
+    init_edits(self);
+
+    // Immutable storage starts out undefined
+    upload_rows(self, 0, rows);
+
+    return self;
+}
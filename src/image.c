@@ -0,0 +1,215 @@
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_BMP
+
+#include "image.h"
+#include "stb_image.h"
+
+#define DITHER_SIZE 8
+
+static const unsigned char bayer[DITHER_SIZE][DITHER_SIZE] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21},
+};
+
+typedef struct image_band_t {
+    image_t *image;
+    life_t *life;
+    // Board rows [first_row, last_row) counted from the top, each cell sampled from image pixel (ys[row], xs[column])
+    int first_row;
+    int last_row;
+    int left;
+    int columns;
+    const int *xs;
+    const int *ys;
+} image_band_t;
+
+/**
+ * How dark the pixel is, 0 for white through 255 for black, with alpha blending it over white
+*/
+static inline unsigned int pixel_ink(const unsigned char *pixel, int channels) {
+    unsigned int luminance;
+    unsigned int alpha = 255;
+
+    if (channels >= 3) {
+        // Same integer weights stb uses for its own grey conversion
+        luminance = (pixel[0] * 77 + pixel[1] * 150 + pixel[2] * 29) >> 8;
+        if (channels == 4)
+            alpha = pixel[3];
+    } else {
+        luminance = pixel[0];
+        if (channels == 2)
+            alpha = pixel[1];
+    }
+
+    return ((255 - luminance) * (alpha + 1)) >> 8;
+}
+
+/**
+ * Kept branch free over the columns so the compiler can vectorize it once channels is a constant
+*/
+static inline void convert_row(bool *cells, const unsigned char *pixels, const int *xs, int columns, int channels, const unsigned short *cut_offs) {
+    for (int j = 0; j < columns; j++) {
+        cells[j] |= pixel_ink(pixels + xs[j] * channels, channels) >= cut_offs[j % DITHER_SIZE];
+    }
+}
+
+static void *convert_band(void *arg) {
+    image_band_t *band = (image_band_t *)arg;
+    image_t *image = band->image;
+    life_t *life = band->life;
+
+    // Wider than a byte, a threshold of 0 cuts off at 256 so no pixel is dark enough
+    unsigned short cut_offs[DITHER_SIZE];
+    size_t stride = (size_t)image->columns * image->_channels;
+
+    for (int i = band->first_row; i < band->last_row; i++) {
+        // Ink above the cut off is alive, so a luminance threshold t becomes 256 - t
+        for (int k = 0; k < DITHER_SIZE; k++) {
+            int column = band->left + k;
+            cut_offs[k] = image->dither
+                ? bayer[i % DITHER_SIZE][column % DITHER_SIZE] * 4 + 2
+                : 256 - image->threshold;
+        }
+
+        bool *cells = &life->grid[life->rows - 1 - i][band->left];
+        const unsigned char *pixels = image->_pixels + band->ys[i] * stride;
+
+        switch (image->_channels) {
+            case 1:
+                convert_row(cells, pixels, band->xs, band->columns, 1, cut_offs);
+                break;
+            case 2:
+                convert_row(cells, pixels, band->xs, band->columns, 2, cut_offs);
+                break;
+            case 3:
+                convert_row(cells, pixels, band->xs, band->columns, 3, cut_offs);
+                break;
+            default:
+                convert_row(cells, pixels, band->xs, band->columns, 4, cut_offs);
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+static void convert(image_t *self, life_t *life, int first_row, int last_row, int left, int columns, const int *xs, const int *ys) {
+    if (life->grid == NULL) {
+        error("Images can only be loaded onto a board held in memory");
+    }
+
+    if (last_row <= first_row || columns <= 0)
+        return;
+
+    int num_threads = get_num_threads();
+    if (num_threads > last_row - first_row)
+        num_threads = last_row - first_row;
+
+    image_band_t *bands = (image_band_t *)calloc(num_threads, sizeof(image_band_t));
+    if (bands == NULL) {
+        error("Unable to allocate memory for image bands");
+    }
+
+    int rows = last_row - first_row;
+
+    for (int i = 0; i < num_threads; i++) {
+        bands[i] = (image_band_t){
+            self,
+            life,
+            first_row + (int)((long)rows * i / num_threads),
+            first_row + (int)((long)rows * (i + 1) / num_threads),
+            left,
+            columns,
+            xs,
+            ys,
+        };
+    }
+
+    run_threads(convert_band, bands, sizeof(image_band_t), num_threads);
+    life->refresh(life);
+
+    free(bands);
+}
+
+static int *alloc_indices(int count) {
+    int *indices = (int *)malloc(count * sizeof(int));
+    if (indices == NULL) {
+        error("Unable to allocate memory for image sampling");
+    }
+
+    return indices;
+}
+
+static void load(image_t *self, life_t *life, int top, int left) {
+    // Clip the image to the board, xs and ys map board cells back onto pixels
+    int first_row = top < 0 ? 0 : top;
+    int last_row = top + self->rows < life->rows ? top + self->rows : life->rows;
+    int first_column = left < 0 ? 0 : left;
+    int last_column = left + self->columns < life->columns ? left + self->columns : life->columns;
+
+    if (last_row <= first_row || last_column <= first_column)
+        return;
+
+    int *xs = alloc_indices(last_column - first_column);
+    int *ys = alloc_indices(life->rows);
+
+    for (int j = first_column; j < last_column; j++)
+        xs[j - first_column] = j - left;
+    for (int i = first_row; i < last_row; i++)
+        ys[i] = i - top;
+
+    convert(self, life, first_row, last_row, first_column, last_column - first_column, xs, ys);
+
+    free(xs);
+    free(ys);
+}
+
+static void load_scaled(image_t *self, life_t *life) {
+    int *xs = alloc_indices(life->columns);
+    int *ys = alloc_indices(life->rows);
+
+    // Nearest pixel to each cell's center
+    for (int j = 0; j < life->columns; j++)
+        xs[j] = (int)(((long)j * 2 + 1) * self->columns / ((long)life->columns * 2));
+    for (int i = 0; i < life->rows; i++)
+        ys[i] = (int)(((long)i * 2 + 1) * self->rows / ((long)life->rows * 2));
+
+    convert(self, life, 0, life->rows, 0, life->columns, xs, ys);
+
+    free(xs);
+    free(ys);
+}
+
+image_t *init_image(const char *file_name) {
+    image_t *self;
+    self = (image_t *)calloc(1, sizeof(image_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for image.");
+    }
+
+    // Keep the file's own channels, the grey conversion happens in the same pass as the threshold
+    self->_pixels = stbi_load(file_name, &self->columns, &self->rows, &self->_channels, 0);
+    if (self->_pixels == NULL) {
+        error(str_concat(str_concat(str_concat("Unable to load image ", file_name), ": "), stbi_failure_reason()));
+    }
+
+    self->threshold = 128;
+    self->dither = false;
+    self->load = load;
+    self->load_scaled = load_scaled;
+
+    return self;
+}
+
+void destroy_image(image_t *self) {
+    stbi_image_free(self->_pixels);
+    free(self);
+}
@@ -1,43 +1,33 @@
 #include "lib/shader.h"
 
-static char *read_file(const char *fileName)
-{
-    FILE *file = fopen(fileName, "r");
-
-    if (file == NULL)
-    {
-        error(str_concat("Unable to open file ", fileName));
-    }
+// Program binaries are cached here, below $XDG_CACHE_HOME or ~/.cache
+#define SHADER_CACHE_DIRECTORY "sea-of-life"
+// Written ahead of each cached binary so a file from another build is never handed to the driver
+#define SHADER_CACHE_MAGIC 0x5345414c494645ULL
 
-    fseek(file, 0L, SEEK_END);
-
-    long lSize = ftell(file);
-    rewind(file);
-
-    // Leave room for null terminated string
-    char *buffer = (char *)malloc(lSize + 1);
-
-    if (buffer == NULL)
-    {
-        fclose(file);
-        error("Unable to allocate memory to read file");
-    }
+typedef struct shader_cache_header_t
+{
+    uint64_t magic;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+} shader_cache_header_t;
 
-    if (!fread(buffer, lSize, 1, file))
+static const char *find_source(const char *name)
+{
+    for (int i = 0; i < num_embedded_shaders; i++)
     {
-        fclose(file);
-        error(str_concat("Unable to read file ", fileName));
+        if (strcmp(embedded_shaders[i].name, name) == 0)
+            return embedded_shaders[i].source;
     }
 
-    buffer[lSize] = '\0';
-
-    fclose(file);
-    return buffer;
+    error(str_concat("No embedded shader named ", name));
+    return NULL;
 }
 
-static unsigned int compile_glsl_shader(const char *fileName, GLenum shaderType)
+static unsigned int compile_glsl_shader(const char *name, GLenum shaderType)
 {
-    const char *source = read_file(fileName);
+    const char *source = find_source(name);
 
     int success;
     char infoLog[512];
@@ -53,24 +43,223 @@ static unsigned int compile_glsl_shader(const char *fileName, GLenum shaderType)
     if (!success)
     {
         glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        const char *message = str_concat(str_concat(str_concat("Shader compilation failed for file: ", fileName), "\n"), infoLog);
+        const char *message = str_concat(str_concat(str_concat("Shader compilation failed for file: ", name), "\n"), infoLog);
         error(message);
     }
 
     return shader;
 }
 
-static int getUniformLocation(int ID, const char *variableName)
+/**
+ * FNV-1a, the terminating null is hashed too so neighbouring strings can't run into each other
+*/
+static uint64_t hash_string(uint64_t hash, const char *text)
+{
+    do
+    {
+        hash ^= (unsigned char)*text;
+        hash *= 0x100000001B3ULL;
+    } while (*text++ != '\0');
+
+    return hash;
+}
+
+/**
+ * A binary only suits the driver that produced it, so the driver is hashed along with the sources
+*/
+static uint64_t program_key(const char **names, const GLenum *types, int count)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+
+    for (int i = 0; i < 3; i++)
+    {
+        const char *value = (const char *)glGetString(strings[i]);
+        hash = hash_string(hash, value != NULL ? value : "");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        hash ^= types[i];
+        hash *= 0x100000001B3ULL;
+        hash = hash_string(hash, find_source(names[i]));
+    }
+
+    return hash;
+}
+
+static char *cache_path(uint64_t key)
+{
+    const char *base = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    char *path;
+
+    if (base != NULL && base[0] == '/')
+        path = (char *)str_concat(base, "/" SHADER_CACHE_DIRECTORY "/");
+    else if (home != NULL && home[0] != '\0')
+        path = (char *)str_concat(home, "/.cache/" SHADER_CACHE_DIRECTORY "/");
+    else
+        return NULL;
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+
+    char *file = (char *)str_concat(path, name);
+    free(path);
+    return file;
+}
+
+static bool load_binary(unsigned int shaderProgramID, const char *path, uint64_t key)
+{
+    FILE *file = fopen(path, "rb");
+    shader_cache_header_t header;
+    bool loaded = false;
+
+    if (file == NULL)
+        return false;
+
+    if (fread(&header, sizeof(header), 1, file) == 1 && header.magic == SHADER_CACHE_MAGIC && header.key == key)
+    {
+        void *binary = malloc(header.length > 0 ? header.length : 1);
+
+        if (binary != NULL && fread(binary, header.length, 1, file) == 1)
+        {
+            int success;
+
+            // A driver update can reject a binary it once produced, the caller then compiles from source
+            glProgramBinary(shaderProgramID, header.format, binary, header.length);
+            glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &success);
+            loaded = success;
+        }
+
+        free(binary);
+    }
+
+    fclose(file);
+    return loaded;
+}
+
+static void make_parent_directories(const char *path)
+{
+    char *directory = (char *)str_concat(path, "");
+
+    for (char *slash = strchr(directory + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/'))
+    {
+        *slash = '\0';
+        mkdir(directory, 0755);
+        *slash = '/';
+    }
+
+    free(directory);
+}
+
+/**
+ * Written beside the cache file and renamed over it, so a second instance never reads half a binary.
+ * The cache only saves time, failing to write it is not an error.
+*/
+static void save_binary(unsigned int shaderProgramID, const char *path, uint64_t key)
 {
-    int uniformVarLocation = glGetUniformLocation(ID, variableName);
+    int length = 0;
+    glGetProgramiv(shaderProgramID, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+        return;
+
+    void *binary = malloc(length);
+    if (binary == NULL)
+        return;
+
+    shader_cache_header_t header = {SHADER_CACHE_MAGIC, key, 0, 0};
+    GLenum format;
+    int written;
+
+    glGetProgramBinary(shaderProgramID, length, &written, &format, binary);
+    header.format = format;
+    header.length = written;
 
-    if (uniformVarLocation == -1)
+    make_parent_directories(path);
+
+    char *temporary = (char *)str_concat(path, ".tmp");
+    FILE *file = fopen(temporary, "wb");
+
+    if (file != NULL)
+    {
+        bool saved = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary, written, 1, file) == 1;
+
+        if (fclose(file) != 0 || !saved || rename(temporary, path) != 0)
+            remove(temporary);
+    }
+
+    free(temporary);
+    free(binary);
+}
+
+static int compare_uniforms(const void *a, const void *b)
+{
+    return strcmp(((const shader_uniform_t *)a)->name, ((const shader_uniform_t *)b)->name);
+}
+
+static void load_uniforms(shader_t *self)
+{
+    int count;
+    glGetProgramInterfaceiv(self->ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+    self->uniforms = (shader_uniform_t *)malloc((count > 0 ? count : 1) * sizeof(shader_uniform_t));
+    if (self->uniforms == NULL)
+    {
+        error("Unable to allocate memory for shader uniforms");
+    }
+
+    self->num_uniforms = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        static const GLenum properties[] = {GL_NAME_LENGTH, GL_LOCATION};
+        int values[2];
+
+        glGetProgramResourceiv(self->ID, GL_UNIFORM, i, 2, properties, 2, NULL, values);
+
+        // Members of uniform blocks have no location, they are set through their buffer
+        if (values[1] == -1)
+            continue;
+
+        char *name = (char *)malloc(values[0]);
+        if (name == NULL)
+        {
+            error("Unable to allocate memory for shader uniforms");
+        }
+
+        glGetProgramResourceName(self->ID, GL_UNIFORM, i, values[0], NULL, name);
+        self->uniforms[self->num_uniforms++] = (shader_uniform_t){name, values[1]};
+    }
+
+    qsort(self->uniforms, self->num_uniforms, sizeof(shader_uniform_t), compare_uniforms);
+}
+
+static int getUniformLocation(shader_t *self, const char *variableName)
+{
+    shader_uniform_t key = {(char *)variableName, -1};
+    shader_uniform_t *uniform = (shader_uniform_t *)bsearch(&key, self->uniforms, self->num_uniforms, sizeof(shader_uniform_t), compare_uniforms);
+
+    if (uniform == NULL)
     {
         const char *message = "Failed to get uniform location: ";
         error(str_concat(message, variableName));
     }
 
-    return uniformVarLocation;
+    return uniform->location;
+}
+
+static void bindUniformBlock(shader_t *self, const char *blockName, unsigned int binding)
+{
+    unsigned int index = glGetUniformBlockIndex(self->ID, blockName);
+
+    if (index == GL_INVALID_INDEX)
+    {
+        error(str_concat("Failed to get uniform block: ", blockName));
+    }
+
+    glUniformBlockBinding(self->ID, index, binding);
 }
 
 static void use(shader_t *self)
@@ -80,68 +269,51 @@ static void use(shader_t *self)
 
 static void setUniformBool(shader_t *self, const char *uniformVarName, bool val)
 {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniform1i(location, (int)val);
 }
 
 static void setUniformInt(shader_t *self, const char *uniformVarName, int val)
 {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniform1i(location, val);
 }
 
 static void setUniformFloat(shader_t *self, const char *uniformVarName, float val)
 {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniform1f(location, val);
 }
 
 static void setUniformV2F(shader_t *self, const char *uniformVarName, float v1, float v2) {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniform2f(location, v1, v2);
 }
 
 static void setUniformV3F(shader_t *self, const char *uniformVarName, float v1, float v2, float v3)
 {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniform3f(location, v1, v2, v3);
 }
 
 static void setUniformV4F(shader_t *self, const char *uniformVarName, float v1, float v2, float v3, float v4)
 {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniform4f(location, v1, v2, v3, v4);
 }
 
 static void setUniformM4F(shader_t *self, const char *uniformVarName, mat4 mat)
 {
-    int location = getUniformLocation(self->ID, uniformVarName);
+    int location = getUniformLocation(self, uniformVarName);
     glUniformMatrix4fv(location, 1, GL_FALSE, (float *)mat);
 }
 
-shader_t *init_shader(const char *vertexShaderFilePath, const char *fragmentShaderFilePath)
+static void link_program(unsigned int shaderProgramID)
 {
-
-    // 1. get data from file paths provided
-
-    // 2. Compile the shaders
-    int vertexShaderID = compile_glsl_shader(vertexShaderFilePath, GL_VERTEX_SHADER);
-    int fragmentShaderID = compile_glsl_shader(fragmentShaderFilePath, GL_FRAGMENT_SHADER);
-
-    // 3. Create the shader program
-    unsigned int shaderProgramID = glCreateProgram();
-
-    // 4. Attach shaders to program
-    glAttachShader(shaderProgramID, vertexShaderID);
-    glAttachShader(shaderProgramID, fragmentShaderID);
-
-    // 5. Link shaders within program
-    glLinkProgram(shaderProgramID);
-
-    // 6. Check whether process was successful
     int success;
     char infoLog[512];
 
+    glLinkProgram(shaderProgramID);
     glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &success);
 
     if (!success)
@@ -150,12 +322,10 @@ shader_t *init_shader(const char *vertexShaderFilePath, const char *fragmentShad
         const char *message = str_concat("Shader compilation failed\n", infoLog);
         error(message);
     }
+}
 
-    // 7. cleanup shaders
-    glDeleteShader(vertexShaderID);
-    glDeleteShader(fragmentShaderID);
-
-    // 8. create struct
+static shader_t *create_shader(unsigned int shaderProgramID)
+{
     shader_t *s = (shader_t *)malloc(sizeof(shader_t));
 
     if (s == NULL)
@@ -163,9 +333,10 @@ shader_t *init_shader(const char *vertexShaderFilePath, const char *fragmentShad
         error("Failed to instantiate shader.");
     }
 
-    // 9. assign function pointers
     s->ID = shaderProgramID;
     s->use = use;
+    s->getUniformLocation = getUniformLocation;
+    s->bindUniformBlock = bindUniformBlock;
     s->setUniformBool = setUniformBool;
     s->setUniformFloat = setUniformFloat;
     s->setUniformInt = setUniformInt;
@@ -174,10 +345,82 @@ shader_t *init_shader(const char *vertexShaderFilePath, const char *fragmentShad
     s->setUniformV4F = setUniformV4F;
     s->setUniformM4F = setUniformM4F;
 
+    load_uniforms(s);
+
     return s;
 }
 
+/**
+ * Links the named embedded shaders into a program, from the binary cache when the driver kept one
+*/
+static unsigned int build_program(const char **names, const GLenum *types, int count)
+{
+    unsigned int shaderProgramID = glCreateProgram();
+    int formats = 0;
+    char *path = NULL;
+    uint64_t key = 0;
+
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+    if (formats > 0)
+    {
+        key = program_key(names, types, count);
+        path = cache_path(key);
+    }
+
+    if (path != NULL && load_binary(shaderProgramID, path, key))
+    {
+        free(path);
+        return shaderProgramID;
+    }
+
+    unsigned int shaderIDs[count];
+
+    for (int i = 0; i < count; i++)
+    {
+        shaderIDs[i] = compile_glsl_shader(names[i], types[i]);
+        glAttachShader(shaderProgramID, shaderIDs[i]);
+    }
+
+    if (path != NULL)
+        glProgramParameteri(shaderProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    link_program(shaderProgramID);
+
+    for (int i = 0; i < count; i++)
+    {
+        glDetachShader(shaderProgramID, shaderIDs[i]);
+        glDeleteShader(shaderIDs[i]);
+    }
+
+    if (path != NULL)
+        save_binary(shaderProgramID, path, key);
+
+    free(path);
+    return shaderProgramID;
+}
+
+shader_t *init_shader(const char *vertexShaderName, const char *fragmentShaderName)
+{
+    const char *names[] = {vertexShaderName, fragmentShaderName};
+    const GLenum types[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+
+    return create_shader(build_program(names, types, 2));
+}
+
+shader_t *init_compute_shader(const char *computeShaderName)
+{
+    const char *names[] = {computeShaderName};
+    const GLenum types[] = {GL_COMPUTE_SHADER};
+
+    return create_shader(build_program(names, types, 1));
+}
+
 void destroy_shader(shader_t *self)
 {
+    for (int i = 0; i < self->num_uniforms; i++)
+        free(self->uniforms[i].name);
+
+    free(self->uniforms);
     free(self);
 }
\ No newline at end of file
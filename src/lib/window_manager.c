@@ -29,8 +29,12 @@ static void process_inputs(window_manager_t *self, struct timeval *delta_time) {
     for (int i = 0; i < inputs->length; i++) {
         input_t *input = ((input_t **)inputs->items)[i];
 
-        if (poll_for_key_input(self, input->key)) 
+        bool held = poll_for_key_input(self, input->key) == press;
+
+        if (held && !(input->once && input->_held))
             input->callback(delta_time);
+
+        input->_held = held;
     }
 }
 
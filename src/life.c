@@ -1,6 +1,34 @@
 #include "life.h"
+#include <stdint.h>
 
 #define STRIDE 4
+// Auto growing boards grow once live cells come this close to an edge
+#define GROW_MARGIN 16
+// Dead cells allocated on either side of every row, so 8 cell words can be read across the edges
+#define ROW_PADDING 8
+#define CELLS_PER_WORD 8
+#define ONES 0x0101010101010101ULL
+// Multiplying a word of 0 or 1 bytes by this gathers byte k into bit 56 + k
+#define GATHER_BITS 0x0102040810204080ULL
+
+static bool *alloc_row(int columns) {
+    bool *row = (bool *)calloc(columns + 2 * ROW_PADDING, sizeof(bool));
+    if (row == NULL) {
+        error("Unable to allocate memory for board row");
+    }
+
+    return row + ROW_PADDING;
+}
+
+static void free_row(bool *row) {
+    free(row - ROW_PADDING);
+}
+
+static inline uint64_t load_cells(const bool *cells) {
+    uint64_t word;
+    memcpy(&word, cells, sizeof(word));
+    return word;
+}
 
 static void print_grid(bool **grid, int rows, int columns) {
     char *line;
@@ -65,10 +93,320 @@ static void swap(life_t *self) {
     tmp = self->grid;
     self->grid = self->shadow_grid;
     self->shadow_grid = tmp;
+
+    life_bounds_t bounds = self->bounds;
+    self->bounds = self->_shadow_bounds;
+    self->_shadow_bounds = bounds;
+}
+
+static const life_bounds_t empty_bounds = {0, 0, -1, -1};
+
+bool bounds_empty(life_bounds_t bounds) {
+    return bounds.max_x < bounds.min_x || bounds.max_y < bounds.min_y;
+}
+
+life_bounds_t bounds_union(life_bounds_t a, life_bounds_t b) {
+    if (bounds_empty(a))
+        return b;
+    if (bounds_empty(b))
+        return a;
+
+    return (life_bounds_t){
+        a.min_x < b.min_x ? a.min_x : b.min_x,
+        a.min_y < b.min_y ? a.min_y : b.min_y,
+        a.max_x > b.max_x ? a.max_x : b.max_x,
+        a.max_y > b.max_y ? a.max_y : b.max_y,
+    };
+}
+
+life_bounds_t bounds_intersect(life_bounds_t a, life_bounds_t b) {
+    return (life_bounds_t){
+        a.min_x > b.min_x ? a.min_x : b.min_x,
+        a.min_y > b.min_y ? a.min_y : b.min_y,
+        a.max_x < b.max_x ? a.max_x : b.max_x,
+        a.max_y < b.max_y ? a.max_y : b.max_y,
+    };
+}
+
+/**
+ * Grows the bounds by margin cells on every side, clipped to the board
+*/
+life_bounds_t bounds_expand(life_bounds_t bounds, int margin, int rows, int columns) {
+    if (bounds_empty(bounds))
+        return bounds;
+
+    return (life_bounds_t){
+        bounds.min_x - margin > 0 ? bounds.min_x - margin : 0,
+        bounds.min_y - margin > 0 ? bounds.min_y - margin : 0,
+        bounds.max_x + margin < rows - 1 ? bounds.max_x + margin : rows - 1,
+        bounds.max_y + margin < columns - 1 ? bounds.max_y + margin : columns - 1,
+    };
+}
+
+void reset_tiles(life_t *self) {
+    if (self->tile_size == 0)
+        self->tile_size = LIFE_TILE_SIZE;
+
+    self->tile_rows = (self->rows + self->tile_size - 1) / self->tile_size;
+    self->tile_columns = (self->columns + self->tile_size - 1) / self->tile_size;
+
+    size_t count = (size_t)self->tile_rows * self->tile_columns;
+    unsigned long *tile_revisions = (unsigned long *)realloc(self->tile_revisions, count * sizeof(unsigned long));
+    if (tile_revisions == NULL) {
+        error("Unable to allocate memory for board tiles");
+    }
+
+    for (size_t i = 0; i < count; i++)
+        tile_revisions[i] = self->revision;
+
+    self->tile_revisions = tile_revisions;
+}
+
+static void include_cell(life_bounds_t *bounds, int x, int y) {
+    if (bounds_empty(*bounds)) {
+        *bounds = (life_bounds_t){x, y, x, y};
+        return;
+    }
+
+    if (x < bounds->min_x) bounds->min_x = x;
+    if (x > bounds->max_x) bounds->max_x = x;
+    if (y < bounds->min_y) bounds->min_y = y;
+    if (y > bounds->max_y) bounds->max_y = y;
+}
+
+static life_bounds_t scan_bounds(bool **grid, int rows, int columns) {
+    life_bounds_t bounds = empty_bounds;
+
+    for (int i = 0; i < rows; i++) {
+        const bool *first = memchr(grid[i], true, columns);
+        if (first == NULL)
+            continue;
+
+        int last = columns - 1;
+        while (!grid[i][last])
+            last--;
+
+        include_cell(&bounds, i, first - grid[i]);
+        include_cell(&bounds, i, last);
+    }
+
+    return bounds;
+}
+
+/**
+ * Only the row pointers move, the rows themselves are reused as they are
+*/
+static void grow_rows(life_t *self, int rows) {
+    int below = (rows - self->rows) / 2;
+    bool **grids[2] = {self->grid, self->shadow_grid};
+
+    for (int k = 0; k < 2; k++) {
+        bool **grid = (bool **)calloc(rows, sizeof(bool *));
+        if (grid == NULL) {
+            error("Unable to allocate memory for board rows");
+        }
+
+        for (int i = 0; i < rows; i++)
+            grid[i] = i >= below && i < below + self->rows ? grids[k][i - below] : alloc_row(self->columns);
+
+        free(grids[k]);
+        grids[k] = grid;
+    }
+
+    self->grid = grids[0];
+    self->shadow_grid = grids[1];
+    self->rows = rows;
+    self->origin_x += below;
+
+    if (!bounds_empty(self->bounds)) {
+        self->bounds.min_x += below;
+        self->bounds.max_x += below;
+    }
+    if (!bounds_empty(self->_shadow_bounds)) {
+        self->_shadow_bounds.min_x += below;
+        self->_shadow_bounds.max_x += below;
+    }
+}
+
+/**
+ * Every row needs a longer allocation, but only the rows holding live cells have anything to copy.
+ * The shadow grid is dropped, the next sweep rewrites all of its cells that matter.
+*/
+static void grow_columns(life_t *self, int columns) {
+    int left = (columns - self->columns) / 2;
+    life_bounds_t bounds = self->bounds;
+
+    for (int i = 0; i < self->rows; i++) {
+        bool *row = alloc_row(columns);
+
+        if (!bounds_empty(bounds) && i >= bounds.min_x && i <= bounds.max_x)
+            memcpy(row + left + bounds.min_y, self->grid[i] + bounds.min_y, bounds.max_y - bounds.min_y + 1);
+
+        free_row(self->grid[i]);
+        self->grid[i] = row;
+
+        free_row(self->shadow_grid[i]);
+        self->shadow_grid[i] = alloc_row(columns);
+    }
+
+    self->columns = columns;
+    self->origin_y += left;
+    self->_shadow_bounds = empty_bounds;
+
+    if (!bounds_empty(self->bounds)) {
+        self->bounds.min_y += left;
+        self->bounds.max_y += left;
+    }
+}
+
+/**
+ * Doubles whichever dimension the live cells are crowding, keeping them centered
+*/
+static void grow_to_fit(life_t *self) {
+    life_bounds_t bounds = self->bounds;
+
+    if (!self->auto_grow || self->torus || bounds_empty(bounds))
+        return;
+
+    int rows = self->rows;
+    while (bounds.min_x + (rows - self->rows) / 2 < GROW_MARGIN ||
+           bounds.max_x + (rows - self->rows) / 2 > rows - 1 - GROW_MARGIN)
+        rows *= 2;
+
+    int columns = self->columns;
+    while (bounds.min_y + (columns - self->columns) / 2 < GROW_MARGIN ||
+           bounds.max_y + (columns - self->columns) / 2 > columns - 1 - GROW_MARGIN)
+        columns *= 2;
+
+    if (rows == self->rows && columns == self->columns)
+        return;
+
+    if (rows != self->rows)
+        grow_rows(self, rows);
+    if (columns != self->columns)
+        grow_columns(self, columns);
+
+    reset_tiles(self);
+}
+
+/**
+ * Live cells in columns first through last of a row
+*/
+static long count_cells(const bool *row, int first, int last) {
+    long count = 0;
+    int j = first;
+
+    for (; j + CELLS_PER_WORD - 1 <= last; j += CELLS_PER_WORD)
+        count += __builtin_popcountll(load_cells(row + j));
+
+    if (j <= last)
+        count += __builtin_popcountll(load_cells(row + j) & (((uint64_t)1 << ((last - j + 1) * 8)) - 1));
+
+    return count;
+}
+
+static long count_population(life_t *self) {
+    life_bounds_t bounds = self->bounds;
+    long population = 0;
+
+    for (int i = bounds.min_x; i <= bounds.max_x; i++)
+        population += count_cells(self->grid[i], bounds.min_y, bounds.max_y);
+
+    return population;
+}
+
+/**
+ * Entry (i, j) holds the live cells in the first i rows and j columns of the live bounds.
+ * Cells outside the bounds are dead, so the table never needs to cover more than them.
+*/
+static void build_area_table(life_t *self) {
+    life_bounds_t bounds = self->bounds;
+
+    self->_area_bounds = bounds;
+    self->_area_stale = false;
+
+    if (bounds_empty(bounds))
+        return;
+
+    size_t width = bounds.max_y - bounds.min_y + 2;
+    size_t size = width * (bounds.max_x - bounds.min_x + 2);
+
+    if (size > self->_area_table_size) {
+        free(self->_area_table);
+        self->_area_table = (uint32_t *)malloc(size * sizeof(uint32_t));
+        if (self->_area_table == NULL) {
+            error("Unable to allocate memory for area table");
+        }
+        self->_area_table_size = size;
+    }
+
+    memset(self->_area_table, 0, width * sizeof(uint32_t));
+
+    for (int i = bounds.min_x; i <= bounds.max_x; i++) {
+        const uint32_t *above = self->_area_table + (size_t)(i - bounds.min_x) * width;
+        uint32_t *out = (uint32_t *)above + width;
+        const bool *row = self->grid[i] + bounds.min_y;
+        uint32_t run = 0;
+
+        out[0] = 0;
+        for (size_t j = 1; j < width; j++) {
+            run += row[j - 1];
+            out[j] = above[j] + run;
+        }
+    }
+}
+
+static long count_alive(life_t *self, int x0, int y0, int x1, int y1) {
+    life_bounds_t area = bounds_intersect((life_bounds_t){x0, y0, x1, y1}, self->bounds);
+    long count = 0;
+
+    if (bounds_empty(area))
+        return 0;
+
+    if (!self->index_area) {
+        for (int i = area.min_x; i <= area.max_x; i++)
+            count += count_cells(self->grid[i], area.min_y, area.max_y);
+
+        return count;
+    }
+
+    if (self->_area_stale)
+        build_area_table(self);
+
+    life_bounds_t table = self->_area_bounds;
+    size_t width = table.max_y - table.min_y + 2;
+    int left = area.min_y - table.min_y, right = area.max_y - table.min_y + 1;
+
+    // Entries wrap around past 2^32, the difference is exact while the strip holds fewer cells than that
+    long strip_rows = UINT32_MAX / (right - left);
+
+    for (long top = area.min_x; top <= area.max_x; top += strip_rows) {
+        long bottom = area.max_x - top < strip_rows ? area.max_x + 1 : top + strip_rows;
+        const uint32_t *first = self->_area_table + (size_t)(top - table.min_x) * width;
+        const uint32_t *last = self->_area_table + (size_t)(bottom - table.min_x) * width;
+
+        count += (uint32_t)(last[right] - last[left] - first[right] + first[left]);
+    }
+
+    return count;
+}
+
+static void refresh(life_t *self) {
+    self->bounds = scan_bounds(self->grid, self->rows, self->columns);
+    self->revision++;
+    reset_tiles(self);
+    grow_to_fit(self);
+
+    self->stats.population = count_population(self);
+    self->stats.births = 0;
+    self->stats.deaths = 0;
+    self->stats.density = (double)self->stats.population / ((double)self->rows * self->columns);
+    self->_area_stale = true;
 }
 
 static void seed(life_t *self) {
     seed_grid(self->grid, self->rows, self->columns);
+    self->refresh(self);
 }
 
 static bool get_alive(life_t *self, int x, int y) {
@@ -76,14 +414,87 @@ static bool get_alive(life_t *self, int x, int y) {
 }
 
 static void set_alive(life_t *self, int x, int y, bool alive) {
-    self->shadow_grid[x][y] = alive;
+    if (self->grid[x][y] == alive)
+        return;
+
+    self->grid[x][y] = alive;
+    self->stats.population += alive ? 1 : -1;
+    self->tile_revisions[(size_t)(x / LIFE_TILE_SIZE) * self->tile_columns + y / LIFE_TILE_SIZE] = ++self->revision;
+    self->_area_stale = true;
+
+    if (alive)
+        include_cell(&self->bounds, x, y);
+}
+
+static void pack_row(life_t *self, int x, int first_word, int num_words, uint64_t *bits) {
+    const bool *row = self->grid[x];
+
+    for (int w = first_word; w < first_word + num_words; w++) {
+        uint64_t word = 0;
+
+        for (int k = 0; k < 64 && w * 64 + k < self->columns; k += CELLS_PER_WORD) {
+            int j = w * 64 + k;
+            uint64_t cells = load_cells(row + j);
+
+            // A torus keeps a wrapped cell in the padding past the last column
+            if (self->columns - j < CELLS_PER_WORD)
+                cells &= ((uint64_t)1 << ((self->columns - j) * 8)) - 1;
+
+            word |= ((cells * GATHER_BITS) >> 56) << k;
+        }
+
+        bits[w - first_word] = word;
+    }
+}
+
+/**
+ * One byte per bit of the low 8 bits
+*/
+static inline uint64_t spread_bits(uint64_t bits) {
+    uint64_t selected = (bits * ONES) & 0x8040201008040201ULL;
+    return ((selected + 0x7F * ONES) >> 7) & ONES;
+}
+
+static inline uint64_t read_bits(const uint64_t *bits, long start) {
+    long index = start / 64;
+    int shift = start % 64;
+
+    return shift == 0 ? bits[index] : (bits[index] >> shift) | (bits[index + 1] << (64 - shift));
+}
+
+/**
+ * Edits 8 cells per word, the source bits spread out to one byte each
+*/
+static void edit_row(life_t *self, int x, int y, const uint64_t *bits, int offset, int count, life_edit_op_e op) {
+    bool *row = self->grid[x] + y;
+    unsigned long *tiles = self->tile_revisions + (size_t)(x / LIFE_TILE_SIZE) * self->tile_columns;
+    long population = 0;
+
+    for (int k = 0; k < count; k += CELLS_PER_WORD) {
+        int length = count - k < CELLS_PER_WORD ? count - k : CELLS_PER_WORD;
+        uint64_t source = spread_bits(read_bits(bits, (long)offset + k) & ((1U << length) - 1));
+        uint64_t cells = load_cells(row + k);
+        uint64_t result = op == life_or ? cells | source : op == life_xor ? cells ^ source : cells & ~source;
+
+        if (result == cells)
+            continue;
+
+        memcpy(row + k, &result, length);
+        population += __builtin_popcountll(result) - __builtin_popcountll(cells);
+
+        uint64_t flipped = result ^ cells;
+        tiles[(y + k + __builtin_ctzll(flipped) / 8) / LIFE_TILE_SIZE] = self->revision;
+        tiles[(y + k + (63 - __builtin_clzll(flipped)) / 8) / LIFE_TILE_SIZE] = self->revision;
+    }
+
+    self->stats.population += population;
 }
 
 static void init_grid(bool ***grid, int rows, int columns) {
     (*grid) = (bool **)calloc(rows, sizeof(bool *));
 
     for (int i = 0; i < rows; i++) {
-        (*grid)[i] = (bool *)calloc(columns, sizeof(bool));
+        (*grid)[i] = alloc_row(columns);
     }
 }
 
@@ -119,25 +530,257 @@ static int get_num_alive_neighbors(life_t *self, int x, int y) {
     return alive_neighbors;
 }
 
-static void live(life_t *self) {
-    for (int i = 0; i < self->rows; i++) {
-        for (int j = 0; j < self->columns; j++) {
-            bool is_alive = self->get_alive(self, i, j);
-            int alive_neighbors = get_num_alive_neighbors(self, i, j);
+/**
+ * 0x01 in every byte of x that is zero, 0x00 elsewhere, for bytes no larger than 0x7F
+*/
+static inline uint64_t zero_bytes(uint64_t x) {
+    return (~(x + 0x7F * ONES) & (0x80 * ONES)) >> 7;
+}
+
+/**
+ * Steps columns first through last of row i, 8 cells per word: every cell is a 0 or 1 byte, so adding the
+ * 9 shifted words of the 3x3 block counts each cell's neighborhood in its own byte, and a popcount of a
+ * word is its population. The last word can run up to 7 cells past last, it is stepped all the same.
+*/
+static void step_row(life_t *self, int i, int first, int last, const bool *dead_row, unsigned long revision,
+                     life_stats_t *stats, life_bounds_t *next_bounds) {
+    const bool *previous = i > 0 ? self->grid[i - 1] : self->torus ? self->grid[self->rows - 1] : dead_row;
+    const bool *row = self->grid[i];
+    const bool *next = i + 1 < self->rows ? self->grid[i + 1] : self->torus ? self->grid[0] : dead_row;
+    bool *out = self->shadow_grid[i];
+    unsigned long *tiles = self->tile_revisions + (size_t)(i / LIFE_TILE_SIZE) * self->tile_columns;
+
+    for (int j = first; j <= last; j += CELLS_PER_WORD) {
+        uint64_t cells = load_cells(row + j);
+        // At most 9 per byte, so no byte carries into the next
+        uint64_t sum = load_cells(previous + j - 1) + load_cells(previous + j) + load_cells(previous + j + 1)
+                     + load_cells(row + j - 1) + cells + load_cells(row + j + 1)
+                     + load_cells(next + j - 1) + load_cells(next + j) + load_cells(next + j + 1);
+
+        // Three in the block is a birth or survival, four only keeps a live cell alive
+        uint64_t result = zero_bytes(sum ^ (3 * ONES)) | (zero_bytes(sum ^ (4 * ONES)) & cells);
+
+        // The last word of a row hangs over the padding, which has to stay dead, and on a torus holds a wrapped cell
+        int count = self->columns - j < CELLS_PER_WORD ? self->columns - j : CELLS_PER_WORD;
+        if (count < CELLS_PER_WORD) {
+            result &= ((uint64_t)1 << (count * 8)) - 1;
+            cells &= ((uint64_t)1 << (count * 8)) - 1;
+        }
 
-            if (is_alive && (alive_neighbors < 2 || alive_neighbors > 3)) {
-                self->set_alive(self, i, j, false);
+        memcpy(out + j, &result, count);
+
+        stats->population += __builtin_popcountll(result);
+        stats->births += __builtin_popcountll(result & ~cells);
+        stats->deaths += __builtin_popcountll(cells & ~result);
+
+        if (result != 0) {
+            include_cell(next_bounds, i, j + __builtin_ctzll(result) / 8);
+            include_cell(next_bounds, i, j + (63 - __builtin_clzll(result)) / 8);
+        }
+
+        // A word can straddle two tiles, so stamp the tiles of its first and last flipped cells
+        uint64_t flipped = result ^ cells;
+        if (flipped != 0) {
+            tiles[(j + __builtin_ctzll(flipped) / 8) / LIFE_TILE_SIZE] = revision;
+            tiles[(j + (63 - __builtin_clzll(flipped)) / 8) / LIFE_TILE_SIZE] = revision;
+        }
+    }
+}
+
+/**
+ * Cells further than one from a live cell stay dead, so only the live bounds plus a margin can change.
+ * The shadow grid's own live cells are swept as well so that stale cells from two generations ago get cleared.
+ * Every stale cell of the shadow grid is inside the sweep, so afterwards it holds exactly next_bounds.
+*/
+static void dense_sweep(life_t *self, life_bounds_t sweep, const bool *dead_row, unsigned long revision,
+                        life_stats_t *stats, life_bounds_t *next_bounds) {
+    for (int i = sweep.min_x; i <= sweep.max_x; i++)
+        step_row(self, i, sweep.min_y, sweep.max_y, dead_row, revision, stats, next_bounds);
+}
+
+/**
+ * Marks the tiles with a tile next to them, or themselves, changed since the last generation started.
+ * No other tile can change, and each of them already holds the same cells in both grids.
+ * Returns how many were marked.
+*/
+static long mark_active_tiles(life_t *self) {
+    int tile_rows = self->tile_rows, tile_columns = self->tile_columns;
+    size_t count = (size_t)tile_rows * tile_columns;
+    long active = 0;
+
+    if (count > self->_active_size) {
+        free(self->_active_tiles);
+        self->_active_tiles = (unsigned char *)malloc(count);
+        if (self->_active_tiles == NULL) {
+            error("Unable to allocate memory for board tiles");
+        }
+        self->_active_size = count;
+    }
+
+    for (int r = 0; r < tile_rows; r++) {
+        unsigned char *marks = self->_active_tiles + (size_t)r * tile_columns;
+
+        memset(marks, false, tile_columns);
+
+        for (int dr = -1; dr <= 1; dr++) {
+            int row = r + dr;
+            if (self->torus)
+                row = (row + tile_rows) % tile_rows;
+            else if (row < 0 || row >= tile_rows)
                 continue;
-            } else if (alive_neighbors == 3) {
-                self->set_alive(self, i, j, true);
+
+            const unsigned long *tiles = self->tile_revisions + (size_t)row * tile_columns;
+
+            for (int c = 0; c < tile_columns; c++) {
+                if (tiles[c] < self->_live_revision)
+                    continue;
+
+                marks[c] = true;
+                if (c > 0 || self->torus)
+                    marks[(c + tile_columns - 1) % tile_columns] = true;
+                if (c + 1 < tile_columns || self->torus)
+                    marks[(c + 1) % tile_columns] = true;
+            }
+        }
+
+        for (int c = 0; c < tile_columns; c++)
+            active += marks[c];
+    }
+
+    return active;
+}
+
+/**
+ * Steps only the runs of active tiles within the sweep. Skipped tiles keep their cells, so their part of
+ * the live bounds is carried over, which can leave next_bounds up to a tile larger than the live cells.
+*/
+static void sparse_sweep(life_t *self, life_bounds_t sweep, const bool *dead_row, unsigned long revision,
+                         life_stats_t *stats, life_bounds_t *next_bounds) {
+    for (int r = sweep.min_x / LIFE_TILE_SIZE; r <= sweep.max_x / LIFE_TILE_SIZE; r++) {
+        const unsigned char *marks = self->_active_tiles + (size_t)r * self->tile_columns;
+        int top = r * LIFE_TILE_SIZE > sweep.min_x ? r * LIFE_TILE_SIZE : sweep.min_x;
+        int bottom = (r + 1) * LIFE_TILE_SIZE - 1 < sweep.max_x ? (r + 1) * LIFE_TILE_SIZE - 1 : sweep.max_x;
+
+        for (int c = sweep.min_y / LIFE_TILE_SIZE; c <= sweep.max_y / LIFE_TILE_SIZE; c++) {
+            life_bounds_t tile = {
+                top, c * LIFE_TILE_SIZE > sweep.min_y ? c * LIFE_TILE_SIZE : sweep.min_y,
+                bottom, (c + 1) * LIFE_TILE_SIZE - 1 < sweep.max_y ? (c + 1) * LIFE_TILE_SIZE - 1 : sweep.max_y,
+            };
+
+            if (!marks[c]) {
+                *next_bounds = bounds_union(*next_bounds, bounds_intersect(tile, self->bounds));
                 continue;
             }
 
-            self->set_alive(self, i, j, is_alive);
+            // Sweeping a run of active tiles one row at a time keeps the reads sequential
+            while (c + 1 <= sweep.max_y / LIFE_TILE_SIZE && marks[c + 1])
+                c++;
+            tile.max_y = (c + 1) * LIFE_TILE_SIZE - 1 < sweep.max_y ? (c + 1) * LIFE_TILE_SIZE - 1 : sweep.max_y;
+
+            for (int i = top; i <= bottom; i++)
+                step_row(self, i, tile.min_y, tile.max_y, dead_row, revision, stats, next_bounds);
         }
     }
+}
 
+/**
+ * Estimated nanoseconds each sweep would take over the sampled generation, from the benchmark in the
+ * commit that added them: a dense sweep costs the same per cell at any density, a sparse one pays for
+ * marking every tile of the board on top of stepping the active ones.
+*/
+static void choose_sweep(life_t *self, life_bounds_t sweep, long active, const life_stats_t *stats) {
+    long board_tiles = (long)self->tile_rows * self->tile_columns;
+    double swept = bounds_empty(sweep) ? 0.0 : (double)(sweep.max_x - sweep.min_x + 1) * (sweep.max_y - sweep.min_y + 1);
+    double dense = swept * LIFE_DENSE_NS_PER_CELL;
+    double sparse = (double)active * LIFE_TILE_SIZE * LIFE_TILE_SIZE * LIFE_SPARSE_NS_PER_CELL + board_tiles * LIFE_MARK_NS_PER_TILE;
+    double density = (double)stats->population / ((double)self->rows * self->columns);
+    double growth = self->_sampled_area > 0 ? swept / self->_sampled_area : 1.0;
+    life_sweep_e choice = self->sweep;
+
+    self->_sampled_area = swept;
+
+    // Switching back and forth costs nothing but the log, the margin only keeps close calls from flapping.
+    // A fast growing pattern is about to reach tiles that are still quiet, so it stays dense.
+    if (self->sweep == life_dense_sweep && sparse < dense * (1.0 - LIFE_SWEEP_MARGIN) && growth < LIFE_SWEEP_MAX_GROWTH)
+        choice = life_sparse_sweep;
+    else if (self->sweep == life_sparse_sweep && dense < sparse * (1.0 - LIFE_SWEEP_MARGIN))
+        choice = life_dense_sweep;
+
+    if (choice == self->sweep)
+        return;
+
+    self->sweep = choice;
+    fprintf(stderr, "[ INFO ]: generation %ld: %s sweep, %ld of %ld tiles active, density %.4f, growth %.2fx\n",
+            stats->generation, choice == life_sparse_sweep ? "sparse" : "dense", active, board_tiles, density, growth);
+}
+
+static void live(life_t *self) {
+    // Edits are queued from here on, so the sweep covers every cell they could have touched
+    begin_live(self);
+
+    life_bounds_t sweep = bounds_union(bounds_expand(self->bounds, 1, self->rows, self->columns), self->_shadow_bounds);
+    life_bounds_t next_bounds = empty_bounds;
+    life_stats_t stats = {self->stats.generation + 1, 0, 0, 0, 0.0};
+    unsigned long revision = ++self->revision;
+    long active = -1;
+
+    bool *dead_row = NULL;
+    if (self->torus) {
+        // Cells wrap around, so the whole board is swept and each row's padding holds the cell from its other end
+        sweep = (life_bounds_t){0, 0, self->rows - 1, self->columns - 1};
+
+        for (int i = 0; i < self->rows; i++) {
+            self->grid[i][-1] = self->grid[i][self->columns - 1];
+            self->grid[i][self->columns] = self->grid[i][0];
+        }
+    } else if (!bounds_empty(sweep) && (sweep.min_x == 0 || sweep.max_x == self->rows - 1)) {
+        dead_row = alloc_row(self->columns);
+    }
+
+    bool sample = self->adaptive && self->stats.generation % LIFE_SAMPLE_INTERVAL == 0;
+    if (self->sweep == life_sparse_sweep || sample)
+        active = mark_active_tiles(self);
+
+    if (!bounds_empty(sweep)) {
+        if (self->sweep == life_sparse_sweep)
+            sparse_sweep(self, sweep, dead_row, revision, &stats, &next_bounds);
+        else
+            dense_sweep(self, sweep, dead_row, revision, &stats, &next_bounds);
+    }
+
+    if (dead_row != NULL)
+        free_row(dead_row);
+
+    // The skipped tiles' cells are not counted, but none of them were born or died
+    if (self->sweep == life_sparse_sweep)
+        stats.population = self->stats.population + stats.births - stats.deaths;
+
+    if (sample)
+        choose_sweep(self, sweep, active, &stats);
+
+    self->_live_revision = revision;
+    self->_shadow_bounds = next_bounds;
+    self->stats = stats;
     self->swap(self);
+    grow_to_fit(self);
+    self->stats.density = (double)self->stats.population / ((double)self->rows * self->columns);
+    self->_area_stale = true;
+
+    end_live(self);
+}
+
+static void destroy(life_t *self) {
+    for (int i = 0; i < self->rows; i++) {
+        free_row(self->grid[i]);
+        free_row(self->shadow_grid[i]);
+    }
+    free(self->grid);
+    free(self->shadow_grid);
+    free(self->_area_table);
+    free(self->tile_revisions);
+    free(self->_active_tiles);
+    destroy_edits(self);
+    free(self);
 }
 
 life_t *init_life(int rows, int columns) {
@@ -162,14 +805,22 @@ life_t *init_life(int rows, int columns) {
     self->set_alive = set_alive;
     self->get_alive = get_alive;
     self->live = live;
+    self->get_num_alive_neighbors = get_num_alive_neighbors;
+    self->refresh = refresh;
+    self->count_alive = count_alive;
+    self->pack_row = pack_row;
+    self->_edit_row = edit_row;
+    self->_destroy = destroy;
+    self->bounds = empty_bounds;
+    self->_shadow_bounds = empty_bounds;
+    self->_area_stale = true;
+    self->adaptive = true;
+    reset_tiles(self);
+    init_edits(self);
 
     return self;
 }
 
 void destroy_life(life_t *self) {
-    for (int i = 0; i < self->rows; i++) {
-        free(self->grid[i]);
-    }
-    free(self->grid);
-    free(self);
+    self->_destroy(self);
 }
\ No newline at end of file
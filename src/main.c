@@ -1,15 +1,25 @@
 #define DEBUG
 
 #include <assert.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "life.h"
+#include "image.h"
+#include "pattern.h"
+#include "recorder.h"
+#include "scheduler.h"
+#include "soup.h"
 #include "lib/window_manager.h"
-#include "lib/shader.h"
+#include "render/renderer.h"
 
-float vertices[] = {
-   0.5f, 0.5f 
-};
+// Cell width is multiplied or divided by this every frame a zoom key is held
+#define ZOOM_RATE 1.05f
+#define MAX_CELL_WIDTH 64.0f
+// Generations per second are multiplied or divided by this every frame a speed key is held
+#define SPEED_RATE 1.05
 
 static struct settings_t {
     bool accelerate;
@@ -20,6 +30,29 @@ static struct settings_t {
     vec3 alive_color;
     vec3 background_color;
     struct timeval frame_duration;
+    double speed;
+    const char *pattern_file;
+    const char *image_file;
+    int image_threshold;
+    bool image_dither;
+    bool image_native;
+    const char *save_file;
+    const char *record_file;
+    int keyframe_interval;
+    const char *replay_file;
+    long seek_generation;
+    long seek_step;
+    const char *board_file;
+    size_t memory_budget;
+    bool auto_grow;
+    long soups;
+    int soup_size;
+    int torus_size;
+    long soup_seed;
+    const char *census_file;
+    const char *renderer;
+    const char *lod;
+    bool gpu;
 } settings = {
     true,
     360,
@@ -29,68 +62,72 @@ static struct settings_t {
     {1.0, 1.0, 1.0},
     {0.0, 0.0, 0.0},
     (struct timeval){0, 16000 /* 60 fps == 16ms == 16000us */},
-};
-
-static struct uniforms_t {
-    const char *accelerate;
-    const char *cell;
-    const char *grid_center;
-    const char *cell_width;
-    const char *alive_color;
-    const char *dead_color;
-    const char *model;
-    const char *view;
-    const char *projection;
-} uniforms = {
-    "accelerate",
-    "cell",
-    "gridCenter",
-    "cellWidth",
-    "aliveColor",
-    "deadColor",
-    "model",
-    "view",
-    "projection"
+    60.0,
+    NULL,
+    NULL,
+    128,
+    false,
+    false,
+    "./snapshot.rle",
+    NULL,
+    100,
+    NULL,
+    0,
+    100,
+    NULL,
+    (size_t)256 << 20,
+    false,
+    0,
+    16,
+    64,
+    -1,
+    "./census.txt",
+    "texture",
+    "any",
+    false,
 };
 
 int width = 1;
 int height = 1;
-unsigned int VAO, VBO;
 
 window_manager_t *window_manager;
-shader_t *shader = NULL;
+renderer_t *renderer = NULL;
+// Draws views with cells under a pixel wide
+renderer_t *lod_renderer = NULL;
 life_t *life;
+recorder_t *recorder = NULL;
+scheduler_t *scheduler = NULL;
+player_t *player = NULL;
 vec2 grid_center = {};
+float cell_width = 1.0f;
+// Board origin the camera was last positioned against
+int camera_origin[2] = {0, 0};
+
+static void update_view(void) {
+    renderer_view_t view = {
+        width,
+        height,
+        cell_width,
+        {grid_center[0], grid_center[1]},
+        {settings.alive_color[0], settings.alive_color[1], settings.alive_color[2]},
+        {settings.dead_color[0], settings.dead_color[1], settings.dead_color[2]},
+    };
+
+    renderer->set_view(renderer, &view);
+    lod_renderer->set_view(lod_renderer, &view);
+}
 
 static void load_settings() {
-    if (shader == NULL)
+    if (renderer == NULL || life == NULL)
         return;
 
-    grid_center[0] = (float)(settings.rows / 2);
-    grid_center[1] = (float)(settings.columns / 2);
-
-    shader->use(shader);
-    shader->setUniformV3F(shader, uniforms.alive_color, settings.alive_color[0], settings.alive_color[1], settings.alive_color[2]);
-    shader->setUniformV3F(shader, uniforms.dead_color, settings.dead_color[0], settings.dead_color[1], settings.dead_color[2]);
-    shader->setUniformFloat(shader, uniforms.cell_width, settings.cell_width);
-    shader->setUniformV2F(shader, uniforms.grid_center, grid_center[0], grid_center[1]);
-    shader->setUniformBool(shader, uniforms.accelerate, settings.accelerate);
-
-    mat4 projection;
-    glm_mat4_identity(projection);
-
-    float num_cells_in_width = width / settings.cell_width;
-    float num_cells_in_height = height / settings.cell_width;
+    grid_center[0] = (float)(life->rows / 2);
+    grid_center[1] = (float)(life->columns / 2);
+    camera_origin[0] = life->origin_x;
+    camera_origin[1] = life->origin_y;
+    cell_width = settings.cell_width;
 
-    float left = (num_cells_in_width / -2.0f);
-    float right = (num_cells_in_width / 2.0f);
-    float bottom = (num_cells_in_height / -2.0f);
-    float top = (num_cells_in_height / 2.0f);
-    float near = 0.0f;
-    float far = 100.0f;
-
-    glm_ortho(left, right, bottom, top, near, far, projection);
-    shader->setUniformM4F(shader, uniforms.projection, projection);
+    update_view();
 }
 
 static void on_window_resize(GLFWwindow *_, int w, int h) {
@@ -124,51 +161,114 @@ static void close_window()
 
 static void camera_down(struct timeval *delta_time) {
     float interval = get_interval(settings.frame_duration, delta_time);
-    grid_center[0] -= interval;
-    shader->setUniformV2F(shader, uniforms.grid_center, grid_center[0], grid_center[1]);
+    grid_center[0] -= interval * settings.cell_width / cell_width;
+    update_view();
 }
 
 static void camera_up(struct timeval *delta_time) {
     float interval = get_interval(settings.frame_duration, delta_time);
-    grid_center[0] += interval;
-    shader->setUniformV2F(shader, uniforms.grid_center, grid_center[0], grid_center[1]);
+    grid_center[0] += interval * settings.cell_width / cell_width;
+    update_view();
 }
 
 static void camera_left(struct timeval *delta_time) {
     float interval = get_interval(settings.frame_duration, delta_time);
-    grid_center[1] -= interval;
-    shader->setUniformV2F(shader, uniforms.grid_center, grid_center[0], grid_center[1]);
+    grid_center[1] -= interval * settings.cell_width / cell_width;
+    update_view();
 }
 
 static void camera_right(struct timeval *delta_time) {
     float interval = get_interval(settings.frame_duration, delta_time);
-    grid_center[1] += interval;
-    shader->setUniformV2F(shader, uniforms.grid_center, grid_center[0], grid_center[1]);
+    grid_center[1] += interval * settings.cell_width / cell_width;
+    update_view();
+}
+
+/**
+ * Zooming out stops once the whole board fits in half the window
+*/
+static void zoom(float factor) {
+    float fit = fminf((float)width / life->columns, (float)height / life->rows) / 2.0f;
+    float min_cell_width = fminf(fit, settings.cell_width);
+
+    cell_width = fmaxf(min_cell_width, fminf(MAX_CELL_WIDTH, cell_width * factor));
+    update_view();
+}
+
+static void zoom_in(struct timeval *delta_time) {
+    zoom(powf(ZOOM_RATE, get_interval(settings.frame_duration, delta_time)));
+}
+
+static void zoom_out(struct timeval *delta_time) {
+    zoom(1.0f / powf(ZOOM_RATE, get_interval(settings.frame_duration, delta_time)));
+}
+
+static void speed_up(struct timeval *delta_time) {
+    scheduler->set_rate(scheduler, scheduler->rate * pow(SPEED_RATE, get_interval(settings.frame_duration, delta_time)));
+}
+
+static void slow_down(struct timeval *delta_time) {
+    scheduler->set_rate(scheduler, scheduler->rate / pow(SPEED_RATE, get_interval(settings.frame_duration, delta_time)));
 }
 
 static void reset_camera() {
-    grid_center[0] = (float)(settings.rows / 2);
-    grid_center[1] = (float)(settings.columns / 2);
-    shader->setUniformV2F(shader, uniforms.grid_center, grid_center[0], grid_center[1]);
+    grid_center[0] = (float)(life->rows / 2);
+    grid_center[1] = (float)(life->columns / 2);
+    camera_origin[0] = life->origin_x;
+    camera_origin[1] = life->origin_y;
+    cell_width = settings.cell_width;
+    update_view();
 }
 
 static void restart_life() {
+    if (player != NULL) {
+        player->seek(player, life, 0);
+        return;
+    }
+
     life->seed(life);
 }
 
+static void seek_back() {
+    if (player != NULL)
+        player->seek(player, life, player->generation - settings.seek_step);
+}
+
+static void seek_forward() {
+    if (player != NULL)
+        player->seek(player, life, player->generation + settings.seek_step);
+}
+
+static void seek_end() {
+    if (player != NULL)
+        player->seek(player, life, player->generations - 1);
+}
+
+static void save_life() {
+    write_rle(life, settings.save_file);
+}
+
 input_t *keyboard_inputs[] = (input_t *[]){
     &(input_t){GLFW_KEY_ESCAPE, close_window},
     &(input_t){GLFW_KEY_DOWN, camera_down},
     &(input_t){GLFW_KEY_UP, camera_up},
     &(input_t){GLFW_KEY_LEFT, camera_left},
     &(input_t){GLFW_KEY_RIGHT, camera_right},
+    &(input_t){GLFW_KEY_EQUAL, zoom_in},
+    &(input_t){GLFW_KEY_MINUS, zoom_out},
     &(input_t){GLFW_KEY_R, reset_camera},
     &(input_t){GLFW_KEY_SPACE, restart_life},
+    &(input_t){GLFW_KEY_S, save_life, true},
+    &(input_t){GLFW_KEY_LEFT_BRACKET, seek_back, true},
+    &(input_t){GLFW_KEY_RIGHT_BRACKET, seek_forward, true},
+    &(input_t){GLFW_KEY_HOME, restart_life, true},
+    &(input_t){GLFW_KEY_END, seek_end, true},
+    &(input_t){GLFW_KEY_PERIOD, speed_up},
+    &(input_t){GLFW_KEY_COMMA, slow_down},
 };
 
 input_config_t input_config = (input_config_t){
     keyboard_inputs,
-    7,
+    16,
 };
 
 static void init_graphics(void) {
@@ -177,37 +277,86 @@ static void init_graphics(void) {
     window_manager->open_window(window_manager, "Sea of Life", 800, 800, NULL);
     window_manager->set_resize_callback(window_manager, on_window_resize);
 
-    glEnable(GL_PROGRAM_POINT_SIZE);
     glDisable(GL_DEPTH_TEST);
 
-    shader = init_shader("./assets/shaders/cell.vert", "./assets/shaders/cell.frag");
+    if (strcmp(settings.renderer, "points") == 0)
+        renderer = init_point_renderer(settings.accelerate);
+    else if (strcmp(settings.renderer, "instanced") == 0)
+        renderer = init_instanced_renderer();
+    else if (strcmp(settings.renderer, "texture") == 0)
+        renderer = init_texture_renderer();
+    else
+        error(str_concat("Unknown renderer ", settings.renderer));
 
-    glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    // The point sprites read every live cell back, defeating the point of keeping the board on the GPU
+    if (settings.gpu && strcmp(settings.renderer, "texture") != 0)
+        error("The GPU board is drawn with the texture renderer");
 
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    if (strcmp(settings.lod, "any") != 0 && strcmp(settings.lod, "density") != 0)
+        error(str_concat("Unknown level of detail ", settings.lod));
 
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
+    lod_renderer = init_density_renderer(strcmp(settings.lod, "any") == 0);
 }
 
 static void destroy_graphics(void) {
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
-
-    destroy_shader(shader);
+    destroy_renderer(renderer);
+    destroy_renderer(lod_renderer);
 
     window_manager->close_window(window_manager);
     free_window_manager(window_manager);
 }
 
-void game_loop()
-{
+/**
+ * Keeps the camera on the same cells when an auto growing board moves its origin
+*/
+static void follow_origin(void) {
+    if (life->origin_x == camera_origin[0] && life->origin_y == camera_origin[1])
+        return;
+
+    grid_center[0] += life->origin_x - camera_origin[0];
+    grid_center[1] += life->origin_y - camera_origin[1];
+    camera_origin[0] = life->origin_x;
+    camera_origin[1] = life->origin_y;
+
+    update_view();
+}
+
+static void step_life(void) {
+    if (player != NULL) {
+        player->step(player, life);
+        return;
+    }
+
     life->live(life);
+    follow_origin();
+
+    if (recorder != NULL)
+        recorder->record(recorder, life);
+}
+
+/**
+ * Shows the generation and the speed actually reached in the window title, about once a second
+*/
+static void update_title(double elapsed) {
+    static double since_title = 0.0;
+    char title[128];
+
+    since_title += elapsed;
+    if (since_title < 1.0)
+        return;
+
+    since_title = 0.0;
+    snprintf(title, sizeof(title), "Sea of Life - generation %ld - %.1f of %.1f generations/s",
+             player != NULL ? player->generation : life->stats.generation, scheduler->achieved, scheduler->rate);
+    glfwSetWindowTitle(window_manager->window, title);
+}
+
+void game_loop(struct timeval *delta_time)
+{
+    double elapsed = delta_time != NULL ? timeval_to_micro_seconds(*delta_time) / 1000000.0 : 0.0;
+
+    scheduler->run(scheduler, elapsed, step_life);
+    update_title(elapsed);
 
     glClear(GL_COLOR_BUFFER_BIT);
     glClearColor(
@@ -217,35 +366,271 @@ void game_loop()
         1.0f
     );
 
-    for (int i = 0; i < settings.rows; i++) {
-        for (int j = 0; j < settings.columns; j++) {
-            if (!settings.accelerate) {
-                mat4 view;
-                glm_mat4_identity(view);
-                glm_translate(view, (vec3){j - grid_center[1], i - grid_center[0], -1.0f});
-                shader->setUniformM4F(shader, uniforms.view, view);
-            }
-
-            shader->setUniformV3F(
-                shader, 
-                uniforms.cell, 
-                (float)i, 
-                (float)j, 
-                (float)life->get_alive(life, i , j)
-            );
-            glDrawArrays(GL_POINTS, 0, 1);
+    if (cell_width < 1.0f)
+        lod_renderer->draw(lod_renderer, life);
+    else
+        renderer->draw(renderer, life);
+}
+
+/**
+ * The whole of value as a number from min to max, otherwise exits with message followed by value
+*/
+static long parse_integer(const char *value, long min, long max, const char *message) {
+    char *end;
+    errno = 0;
+    long number = strtol(value, &end, 10);
+
+    if (end == value || *end != '\0' || errno == ERANGE || number < min || number > max)
+        error(str_concat(message, value));
+
+    return number;
+}
+
+static double parse_real(const char *value, double min, double max, const char *message) {
+    char *end;
+    errno = 0;
+    double number = strtod(value, &end);
+
+    // Written so NaN fails the range check too
+    if (end == value || *end != '\0' || errno == ERANGE || !(number >= min && number <= max))
+        error(str_concat(message, value));
+
+    return number;
+}
+
+static void parse_arguments(int argc, char **argv) {
+    static struct option options[] = {
+        {"pattern", required_argument, NULL, 'p'},
+        {"image", required_argument, NULL, 'i'},
+        {"threshold", required_argument, NULL, 't'},
+        {"dither", no_argument, NULL, 'd'},
+        {"no-scale", no_argument, NULL, 'N'},
+        {"save", required_argument, NULL, 's'},
+        {"record", required_argument, NULL, 'r'},
+        {"keyframe", required_argument, NULL, 'k'},
+        {"replay", required_argument, NULL, 'y'},
+        {"seek", required_argument, NULL, 'g'},
+        {"rows", required_argument, NULL, 'R'},
+        {"columns", required_argument, NULL, 'C'},
+        {"out-of-core", required_argument, NULL, 'o'},
+        {"memory", required_argument, NULL, 'm'},
+        {"auto-grow", no_argument, NULL, 'a'},
+        {"soups", required_argument, NULL, 'n'},
+        {"soup-size", required_argument, NULL, 'z'},
+        {"torus", required_argument, NULL, 'T'},
+        {"soup-seed", required_argument, NULL, 'e'},
+        {"census", required_argument, NULL, 'c'},
+        {"renderer", required_argument, NULL, 'w'},
+        {"lod", required_argument, NULL, 'l'},
+        {"gpu", no_argument, NULL, 'G'},
+        {"speed", required_argument, NULL, 'v'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int option;
+
+    while ((option = getopt_long(argc, argv, "p:i:t:dNs:r:k:y:g:R:C:o:m:an:z:T:e:c:w:l:Gv:", options, NULL)) != -1) {
+        switch (option) {
+            case 'p':
+                settings.pattern_file = optarg;
+                break;
+            case 'i':
+                settings.image_file = optarg;
+                break;
+            case 't':
+                settings.image_threshold = (int)parse_integer(optarg, 0, 255, "--threshold takes a value from 0 to 255, not ");
+                break;
+            case 'd':
+                settings.image_dither = true;
+                break;
+            case 'N':
+                settings.image_native = true;
+                break;
+            case 's':
+                settings.save_file = optarg;
+                break;
+            case 'r':
+                settings.record_file = optarg;
+                break;
+            case 'k':
+                settings.keyframe_interval = (int)parse_integer(optarg, 1, INT_MAX, "--keyframe takes a positive number of generations, not ");
+                break;
+            case 'y':
+                settings.replay_file = optarg;
+                break;
+            case 'g':
+                settings.seek_generation = atol(optarg);
+                break;
+            case 'R':
+                settings.rows = (int)parse_integer(optarg, 1, INT_MAX, "--rows takes a positive number, not ");
+                break;
+            case 'C':
+                settings.columns = (int)parse_integer(optarg, 1, INT_MAX, "--columns takes a positive number, not ");
+                break;
+            case 'o':
+                settings.board_file = optarg;
+                break;
+            case 'm':
+                settings.memory_budget = (size_t)atol(optarg) << 20;
+                break;
+            case 'a':
+                settings.auto_grow = true;
+                break;
+            case 'n':
+                settings.soups = parse_integer(optarg, 1, LONG_MAX, "--soups takes a positive number, not ");
+                break;
+            case 'z':
+                settings.soup_size = (int)parse_integer(optarg, 1, INT_MAX, "--soup-size takes a positive number, not ");
+                break;
+            case 'T':
+                settings.torus_size = (int)parse_integer(optarg, 1, INT_MAX, "--torus takes a positive number, not ");
+                break;
+            case 'e':
+                settings.soup_seed = atol(optarg);
+                break;
+            case 'c':
+                settings.census_file = optarg;
+                break;
+            case 'w':
+                settings.renderer = optarg;
+                break;
+            case 'l':
+                settings.lod = optarg;
+                break;
+            case 'G':
+                settings.gpu = true;
+                break;
+            case 'v':
+                settings.speed = parse_real(optarg, SCHEDULER_MIN_RATE, SCHEDULER_MAX_RATE, "--speed takes 0.1 to 1000000 generations per second, not ");
+                break;
+            default:
+                error("Usage: main [--rows N] [--columns N] [--auto-grow | --out-of-core file [--memory MiB] | --gpu] "
+                      "[--renderer texture|instanced|points] [--lod any|density] [--speed N] [--pattern file.rle] [--image file.png [--threshold 0-255] [--dither] [--no-scale]] [--save file.rle] "
+                      "[--record file.rec [--keyframe N]] [--replay file.rec [--seek generation]] "
+                      "[--soups N [--soup-size N] [--torus N] [--soup-seed N] [--census file.txt]]");
         }
     }
+
+    // Recordings hold one board size, a grown board could no longer be written to them
+    if (settings.auto_grow && settings.record_file != NULL)
+        error("--auto-grow can't be used with --record");
+
+    // The scratch file is sized once, only the in memory board grows
+    if (settings.auto_grow && settings.board_file != NULL)
+        error("--auto-grow can't be used with --out-of-core");
+
+    // The GPU board has a fixed size and lives in video memory, replays are played on an in memory board
+    if (settings.gpu && (settings.auto_grow || settings.board_file != NULL || settings.replay_file != NULL))
+        error("--gpu can't be used with --auto-grow, --out-of-core or --replay");
 }
 
-int main(void) {
-    life = init_life(settings.rows, settings.columns);
-    life->seed(life);
+static life_t *create_life(int rows, int columns) {
+    if (settings.board_file != NULL)
+        return init_file_life(rows, columns, settings.board_file, settings.memory_budget);
+    if (settings.gpu)
+        return init_gpu_life(rows, columns);
+
+    life_t *self = init_life(rows, columns);
+    self->auto_grow = settings.auto_grow;
+
+    return self;
+}
+
+static void init_board(void) {
+    if (settings.replay_file != NULL) {
+        player = init_player(settings.replay_file);
+        settings.rows = player->rows;
+        settings.columns = player->columns;
+
+        life = init_life(settings.rows, settings.columns);
+        player->seek(player, life, settings.seek_generation);
+        return;
+    }
+
+    if (settings.image_file != NULL) {
+        image_t *image = init_image(settings.image_file);
+        image->threshold = settings.image_threshold;
+        image->dither = settings.image_dither;
+
+        life = create_life(settings.rows, settings.columns);
+
+        // One cell per pixel in the middle of the board, cut off at its edges if the image is larger
+        if (settings.image_native)
+            image->load(image, life, (life->rows - image->rows) / 2, (life->columns - image->columns) / 2);
+        else
+            image->load_scaled(image, life);
+
+        destroy_image(image);
+        return;
+    }
+
+    if (settings.pattern_file == NULL) {
+        life = create_life(settings.rows, settings.columns);
+        life->seed(life);
+        return;
+    }
+
+    pattern_t *pattern = init_pattern(settings.pattern_file);
+
+    // Grow the board to fit the pattern, then center the pattern on it
+    if (pattern->rows > settings.rows)
+        settings.rows = pattern->rows;
+    if (pattern->columns > settings.columns)
+        settings.columns = pattern->columns;
+
+    life = create_life(settings.rows, settings.columns);
+    pattern->load(pattern, life, (settings.rows - pattern->rows) / 2, (settings.columns - pattern->columns) / 2);
+
+    destroy_pattern(pattern);
+}
+
+/**
+ * Headless, tallies the objects random soups settle into instead of opening a window
+*/
+static void search_soups(void) {
+    soup_search_t *search = init_soup_search(settings.census_file);
+    search->soup_size = settings.soup_size;
+    search->board_size = settings.torus_size;
+    if (settings.soup_seed >= 0)
+        search->seed = settings.soup_seed;
+
+    search->run(search, settings.soups);
+
+    printf("%ld soups, %ld generations, census in %s\n", search->soups, search->generations, settings.census_file);
+    destroy_soup_search(search);
+}
+
+int main(int argc, char **argv) {
+    parse_arguments(argc, argv);
+
+    if (settings.soups > 0) {
+        search_soups();
+        return 0;
+    }
+
+    // The GPU board is made in the window's GL context
     init_graphics();
-    
+    init_board();
+
+    if (settings.record_file != NULL && player == NULL) {
+        recorder = init_recorder(settings.record_file, life, settings.keyframe_interval);
+        recorder->record(recorder, life);
+    }
+
+    load_settings();
+
+    scheduler = init_scheduler(settings.speed, timeval_to_micro_seconds(settings.frame_duration) / 1000000.0);
+
     // life->live(life);
     window_manager->render(window_manager, game_loop, &settings.frame_duration);
+
+    destroy_scheduler(scheduler);
     
+    if (recorder != NULL)
+        destroy_recorder(recorder);
+    if (player != NULL)
+        destroy_player(player);
+
     destroy_life(life);
     destroy_graphics();
 }
\ No newline at end of file
@@ -0,0 +1,578 @@
+#include "pattern.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define RLE_LINE_LENGTH 70
+#define WRITE_BUFFER_SIZE (1 << 20)
+// Below this the threads cost more to start than the decode itself
+#define PARALLEL_RLE_THRESHOLD (1 << 22)
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static const char *skip_line(const char *cursor, const char *end) {
+    while (cursor < end && *cursor != '\n')
+        cursor++;
+
+    return cursor < end ? cursor + 1 : end;
+}
+
+static const char *parse_long(const char *cursor, const char *end, long *value) {
+    bool negative = false;
+    *value = 0;
+
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor == '-';
+        cursor++;
+    }
+
+    while (cursor < end && is_digit(*cursor)) {
+        *value = *value * 10 + (*cursor - '0');
+        cursor++;
+    }
+
+    if (negative)
+        *value = -*value;
+
+    return cursor;
+}
+
+/**
+ * Pattern rows count down from the top of the board, grid rows count up from the bottom
+*/
+static void fill_run(life_t *life, long row, long column, long count) {
+    if (row < 0 || row >= life->rows)
+        return;
+
+    if (column < 0) {
+        count += column;
+        column = 0;
+    }
+
+    if (column + count > life->columns)
+        count = life->columns - column;
+
+    if (count <= 0)
+        return;
+
+    // File backed boards have no rows in memory, their row cache keeps this sequential
+    if (life->grid == NULL) {
+        for (long j = column; j < column + count; j++)
+            life->set_alive(life, life->rows - 1 - row, j, true);
+        return;
+    }
+
+    memset(&life->grid[life->rows - 1 - row][column], true, count);
+}
+
+/**
+ * Decodes runs from begin up to end or the closing '!', starting at the given pattern row
+*/
+static void decode_rle(life_t *life, const char *begin, const char *end, long row, int left) {
+    const char *cursor = begin;
+
+    long column = left;
+    long count = 0;
+
+    while (cursor < end) {
+        char c = *cursor++;
+
+        if (is_digit(c)) {
+            count = count * 10 + (c - '0');
+            continue;
+        }
+
+        if (is_space(c))
+            continue;
+
+        if (count == 0)
+            count = 1;
+
+        if (c == '!') {
+            break;
+        } else if (c == '$') {
+            row += count;
+            column = left;
+        } else if (c == 'b' || c == '.') {
+            column += count;
+        } else {
+            // 'o' and the multi-state letters are all alive on a two state board
+            fill_run(life, row, column, count);
+            column += count;
+        }
+
+        count = 0;
+    }
+}
+
+typedef struct rle_chunk_t {
+    life_t *life;
+    const char *begin;
+    const char *end;
+    long row;
+    int left;
+    long rows;
+    bool terminated;
+} rle_chunk_t;
+
+/**
+ * Pre-scan: how many rows the chunk advances and whether it holds the closing '!'
+*/
+static void *count_chunk_rows(void *arg) {
+    rle_chunk_t *chunk = (rle_chunk_t *)arg;
+    const char *cursor = chunk->begin;
+    long count = 0;
+
+    while (cursor < chunk->end) {
+        char c = *cursor++;
+
+        if (is_digit(c)) {
+            count = count * 10 + (c - '0');
+            continue;
+        }
+
+        if (c == '!') {
+            chunk->terminated = true;
+            break;
+        }
+
+        if (c == '$')
+            chunk->rows += count == 0 ? 1 : count;
+
+        if (!is_space(c))
+            count = 0;
+    }
+
+    return NULL;
+}
+
+static void *decode_chunk(void *arg) {
+    rle_chunk_t *chunk = (rle_chunk_t *)arg;
+    decode_rle(chunk->life, chunk->begin, chunk->end, chunk->row, chunk->left);
+    return NULL;
+}
+
+/**
+ * Splits the body right after '$' tokens so that every chunk starts on a fresh row at column 0.
+ * Chunks own disjoint bands of rows, so they decode into the board without any locking.
+*/
+static void load_rle_parallel(pattern_t *self, life_t *life, int top, int left, int num_threads) {
+    const char *begin = self->_body;
+    const char *end = self->_data + self->_length;
+    size_t length = end - begin;
+
+    rle_chunk_t *chunks = (rle_chunk_t *)calloc(num_threads, sizeof(rle_chunk_t));
+    if (chunks == NULL) {
+        error("Unable to allocate memory for RLE chunks");
+    }
+
+    int num_chunks = 0;
+    const char *cursor = begin;
+
+    while (cursor < end && num_chunks < num_threads) {
+        const char *split = begin + length / num_threads * (num_chunks + 1);
+
+        if (num_chunks == num_threads - 1 || split <= cursor) {
+            split = end;
+        } else {
+            split = memchr(split, '$', end - split);
+            split = split == NULL ? end : split + 1;
+        }
+
+        chunks[num_chunks++] = (rle_chunk_t){life, cursor, split, 0, left, 0, false};
+        cursor = split;
+    }
+
+    run_threads(count_chunk_rows, chunks, sizeof(rle_chunk_t), num_chunks);
+
+    // Everything after the '!' is free text, so the chunks past it are dropped
+    long row = top;
+
+    for (int i = 0; i < num_chunks; i++) {
+        chunks[i].row = row;
+        row += chunks[i].rows;
+
+        if (chunks[i].terminated) {
+            num_chunks = i + 1;
+            break;
+        }
+    }
+
+    run_threads(decode_chunk, chunks, sizeof(rle_chunk_t), num_chunks);
+
+    free(chunks);
+}
+
+static void load_rle(pattern_t *self, life_t *life, int top, int left) {
+    size_t length = self->_data + self->_length - self->_body;
+    int num_threads = get_num_threads();
+
+    if (length >= PARALLEL_RLE_THRESHOLD && num_threads > 1 && life->grid != NULL) {
+        load_rle_parallel(self, life, top, left, num_threads);
+        return;
+    }
+
+    decode_rle(life, self->_body, self->_data + self->_length, top, left);
+}
+
+static void load_plaintext(pattern_t *self, life_t *life, int top, int left) {
+    const char *cursor = self->_body;
+    const char *end = self->_data + self->_length;
+
+    long row = top;
+
+    while (cursor < end) {
+        if (*cursor == '!') {
+            cursor = skip_line(cursor, end);
+            continue;
+        }
+
+        long column = left;
+
+        while (cursor < end && *cursor != '\n') {
+            const char *run = cursor;
+
+            while (cursor < end && (*cursor == 'O' || *cursor == '*'))
+                cursor++;
+
+            if (cursor > run) {
+                fill_run(life, row, column, cursor - run);
+                column += cursor - run;
+                continue;
+            }
+
+            if (*cursor != '\r')
+                column++;
+            cursor++;
+        }
+
+        cursor = skip_line(cursor, end);
+        row++;
+    }
+}
+
+static void load_life_106(pattern_t *self, life_t *life, int top, int left) {
+    const char *cursor = self->_body;
+    const char *end = self->_data + self->_length;
+
+    while (cursor < end) {
+        long x, y;
+
+        if (*cursor == '#' || is_space(*cursor)) {
+            cursor = skip_line(cursor, end);
+            continue;
+        }
+
+        cursor = parse_long(cursor, end, &x);
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+            cursor++;
+        cursor = parse_long(cursor, end, &y);
+        cursor = skip_line(cursor, end);
+
+        fill_run(life, top + y - self->_min_y, left + x - self->_min_x, 1);
+    }
+}
+
+static void load(pattern_t *self, life_t *life, int top, int left) {
+    switch (self->format) {
+        case pattern_rle:
+            load_rle(self, life, top, left);
+            break;
+        case pattern_plaintext:
+            load_plaintext(self, life, top, left);
+            break;
+        case pattern_life_106:
+            load_life_106(self, life, top, left);
+            break;
+    }
+
+    life->refresh(life);
+}
+
+/**
+ * Reads "x = m, y = n, rule = ..." and leaves the body pointing at the first run
+*/
+static void scan_rle_header(pattern_t *self, const char *cursor, const char *end) {
+    long columns = 0;
+    long rows = 0;
+
+    while (cursor < end && *cursor != '\n') {
+        char key = *cursor++;
+
+        if (key != 'x' && key != 'y')
+            continue;
+
+        while (cursor < end && (*cursor == ' ' || *cursor == '='))
+            cursor++;
+
+        cursor = parse_long(cursor, end, key == 'x' ? &columns : &rows);
+
+        // rule = B3/S23 has no x or y in it, skip the rest of the line once both are read
+        if (columns > 0 && rows > 0)
+            break;
+    }
+
+    if (columns <= 0 || rows <= 0)
+        error("RLE header is missing the pattern size");
+
+    self->columns = columns;
+    self->rows = rows;
+    self->_body = skip_line(cursor, end);
+}
+
+static void scan_plaintext(pattern_t *self, const char *cursor, const char *end) {
+    long rows = 0;
+    long columns = 0;
+
+    while (cursor < end) {
+        if (*cursor == '!') {
+            cursor = skip_line(cursor, end);
+            continue;
+        }
+
+        const char *line = cursor;
+        const char *next = skip_line(cursor, end);
+        long width = next - line;
+
+        while (width > 0 && is_space(line[width - 1]))
+            width--;
+
+        if (width > columns)
+            columns = width;
+
+        rows++;
+        cursor = next;
+    }
+
+    self->rows = rows;
+    self->columns = columns;
+}
+
+static void scan_life_106(pattern_t *self, const char *cursor, const char *end) {
+    long min_x = 0, min_y = 0, max_x = -1, max_y = -1;
+    bool empty = true;
+
+    while (cursor < end) {
+        long x, y;
+
+        if (*cursor == '#' || is_space(*cursor)) {
+            cursor = skip_line(cursor, end);
+            continue;
+        }
+
+        cursor = parse_long(cursor, end, &x);
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+            cursor++;
+        cursor = parse_long(cursor, end, &y);
+        cursor = skip_line(cursor, end);
+
+        if (empty || x < min_x) min_x = x;
+        if (empty || y < min_y) min_y = y;
+        if (empty || x > max_x) max_x = x;
+        if (empty || y > max_y) max_y = y;
+        empty = false;
+    }
+
+    self->_min_x = min_x;
+    self->_min_y = min_y;
+    self->columns = max_x - min_x + 1;
+    self->rows = max_y - min_y + 1;
+}
+
+static void scan_pattern(pattern_t *self) {
+    const char *cursor = self->_data;
+    const char *end = self->_data + self->_length;
+
+    if (self->_length >= 10 && strncmp(cursor, "#Life 1.06", 10) == 0) {
+        self->format = pattern_life_106;
+        self->_body = skip_line(cursor, end);
+        scan_life_106(self, self->_body, end);
+        return;
+    }
+
+    // RLE files open with optional "#" comment lines followed by the "x = " header
+    while (cursor < end && *cursor == '#')
+        cursor = skip_line(cursor, end);
+
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+        cursor++;
+
+    if (cursor < end && *cursor == 'x') {
+        self->format = pattern_rle;
+        scan_rle_header(self, cursor, end);
+        return;
+    }
+
+    self->format = pattern_plaintext;
+    self->_body = self->_data;
+    scan_plaintext(self, self->_body, end);
+}
+
+pattern_t *init_pattern(const char *file_name) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd == -1) {
+        error(str_concat("Unable to open pattern ", file_name));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1 || info.st_size == 0) {
+        close(fd);
+        error(str_concat("Unable to read pattern ", file_name));
+    }
+
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        error(str_concat("Unable to map pattern ", file_name));
+    }
+
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+    pattern_t *self;
+    self = (pattern_t *)calloc(1, sizeof(pattern_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for pattern.");
+    }
+
+    self->_data = data;
+    self->_length = info.st_size;
+    self->load = load;
+
+    scan_pattern(self);
+
+    return self;
+}
+
+void destroy_pattern(pattern_t *self) {
+    munmap((void *)self->_data, self->_length);
+    free(self);
+}
+
+typedef struct rle_writer_t {
+    FILE *file;
+    int line_length;
+} rle_writer_t;
+
+static void write_run(rle_writer_t *writer, long count, char tag) {
+    char token[24];
+    int length;
+
+    if (count > 1)
+        length = sprintf(token, "%ld%c", count, tag);
+    else
+        length = sprintf(token, "%c", tag);
+
+    if (writer->line_length + length > RLE_LINE_LENGTH) {
+        fputc('\n', writer->file);
+        writer->line_length = 0;
+    }
+
+    fputs(token, writer->file);
+    writer->line_length += length;
+}
+
+/**
+ * Rows of file backed boards are copied out cell by cell through their row cache
+*/
+/**
+ * Columns bounds.min_y to bounds.max_y of row x. Boards without a grid pack just those columns' words,
+ * and only the live cells of the words that have any are spread out into cells.
+*/
+static const bool *get_row(life_t *life, int x, life_bounds_t bounds, uint64_t *words, bool *cells) {
+    if (life->grid != NULL)
+        return life->grid[x] + bounds.min_y;
+
+    int first_word = bounds.min_y / 64, num_words = bounds.max_y / 64 - first_word + 1;
+
+    life->pack_row(life, x, first_word, num_words, words);
+    memset(cells, false, bounds.max_y - bounds.min_y + 1);
+
+    for (int w = 0; w < num_words; w++) {
+        for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+            int j = (first_word + w) * 64 + __builtin_ctzll(bits);
+
+            if (j >= bounds.min_y && j <= bounds.max_y)
+                cells[j - bounds.min_y] = true;
+        }
+    }
+
+    return cells;
+}
+
+void write_rle(life_t *life, const char *file_name) {
+    FILE *file = fopen(file_name, "w");
+
+    if (file == NULL) {
+        error(str_concat("Unable to open file ", file_name));
+    }
+
+    // Only the live bounds are written, like any other pattern
+    life_bounds_t bounds = life->bounds;
+    int columns = bounds_empty(bounds) ? 0 : bounds.max_y - bounds.min_y + 1;
+    int rows = bounds_empty(bounds) ? 0 : bounds.max_x - bounds.min_x + 1;
+
+    bool *buffer = NULL;
+    uint64_t *words = NULL;
+    if (life->grid == NULL && rows > 0) {
+        buffer = (bool *)malloc(columns);
+        words = (uint64_t *)malloc((bounds.max_y / 64 - bounds.min_y / 64 + 1) * sizeof(uint64_t));
+        if (buffer == NULL || words == NULL) {
+            error("Unable to allocate memory for RLE row");
+        }
+    }
+
+    setvbuf(file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+    fprintf(file, "x = %d, y = %d, rule = B3/S23\n", columns, rows);
+
+    rle_writer_t writer = (rle_writer_t){file, 0};
+    long pending_rows = 0;
+
+    for (int i = bounds.max_x; i >= bounds.min_x && rows > 0; i--) {
+        const bool *row = get_row(life, i, bounds, words, buffer);
+        const bool *end = row + columns;
+        const bool *cursor = memchr(row, true, columns);
+
+        if (cursor == NULL) {
+            pending_rows++;
+            continue;
+        }
+
+        if (pending_rows > 0)
+            write_run(&writer, pending_rows, '$');
+
+        const bool *dead = row;
+
+        while (cursor != NULL) {
+            if (cursor > dead)
+                write_run(&writer, cursor - dead, 'b');
+
+            const bool *alive = cursor;
+            while (cursor < end && *cursor)
+                cursor++;
+
+            write_run(&writer, cursor - alive, 'o');
+
+            dead = cursor;
+            cursor = cursor < end ? memchr(cursor, true, end - cursor) : NULL;
+        }
+
+        pending_rows = 1;
+    }
+
+    write_run(&writer, 1, '!');
+    fputc('\n', file);
+    free(buffer);
+    free(words);
+
+    if (fclose(file) != 0) {
+        error(str_concat("Unable to write file ", file_name));
+    }
+}
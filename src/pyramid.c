@@ -0,0 +1,347 @@
+#include "pyramid.h"
+
+// Level whose blocks are exactly one tile
+#define TILE_LEVEL (__builtin_ctz(LIFE_TILE_SIZE) - 1)
+
+static inline uint64_t read_count(const pyramid_level_t *level, int x, int y) {
+    size_t index = (size_t)x * level->columns + y;
+
+    switch (level->_width) {
+        case 1:
+            return ((const uint8_t *)level->_counts)[index];
+        case 2:
+            return ((const uint16_t *)level->_counts)[index];
+        case 4:
+            return ((const uint32_t *)level->_counts)[index];
+        default:
+            return ((const uint64_t *)level->_counts)[index];
+    }
+}
+
+static inline void write_count(pyramid_level_t *level, int x, int y, uint64_t count) {
+    size_t index = (size_t)x * level->columns + y;
+
+    switch (level->_width) {
+        case 1:
+            ((uint8_t *)level->_counts)[index] = count;
+            break;
+        case 2:
+            ((uint16_t *)level->_counts)[index] = count;
+            break;
+        case 4:
+            ((uint32_t *)level->_counts)[index] = count;
+            break;
+        default:
+            ((uint64_t *)level->_counts)[index] = count;
+            break;
+    }
+}
+
+static void free_levels(pyramid_t *self) {
+    for (int k = 0; k < self->num_levels; k++)
+        free(self->levels[k]._counts);
+
+    free(self->levels);
+    free(self->_revisions);
+    free(self->_block_counts);
+    self->levels = NULL;
+    self->_revisions = NULL;
+    self->_block_counts = NULL;
+    self->num_levels = 0;
+}
+
+static void resize(pyramid_t *self, life_t *life) {
+    int size = life->rows > life->columns ? life->rows : life->columns;
+
+    free_levels(self);
+
+    // Enough levels for the last one to be a single block
+    self->num_levels = 1;
+    while ((2L << (self->num_levels - 1)) < size)
+        self->num_levels++;
+
+    self->levels = (pyramid_level_t *)calloc(self->num_levels, sizeof(pyramid_level_t));
+    if (self->levels == NULL) {
+        error("Unable to allocate memory for density pyramid");
+    }
+
+    for (int k = 0; k < self->num_levels; k++) {
+        pyramid_level_t *level = &self->levels[k];
+        uint64_t cells = (uint64_t)(2L << k) * (2L << k);
+
+        level->block_size = 2L << k;
+        level->rows = (life->rows + level->block_size - 1) / level->block_size;
+        level->columns = (life->columns + level->block_size - 1) / level->block_size;
+        level->_width = cells <= UINT8_MAX ? 1 : cells <= UINT16_MAX ? 2 : cells <= UINT32_MAX ? 4 : 8;
+    }
+
+    self->first_level = TILE_LEVEL < self->num_levels - 1 ? TILE_LEVEL : self->num_levels - 1;
+    while (self->first_level < self->num_levels - 1 &&
+           (self->levels[self->first_level].rows > PYRAMID_MAX_BLOCKS || self->levels[self->first_level].columns > PYRAMID_MAX_BLOCKS))
+        self->first_level++;
+
+    for (int k = self->first_level; k < self->num_levels; k++) {
+        pyramid_level_t *level = &self->levels[k];
+
+        level->_counts = calloc((size_t)level->rows * level->columns, level->_width);
+        if (level->_counts == NULL) {
+            error("Unable to allocate memory for density pyramid");
+        }
+    }
+
+    const pyramid_level_t *first = &self->levels[self->first_level];
+    self->_revisions = (unsigned long *)calloc((size_t)first->rows * first->columns, sizeof(unsigned long));
+    self->_block_counts = (uint64_t *)malloc(first->columns * sizeof(uint64_t));
+    if (self->_revisions == NULL || self->_block_counts == NULL) {
+        error("Unable to allocate memory for density pyramid");
+    }
+
+    self->_board_rows = life->rows;
+    self->_board_columns = life->columns;
+}
+
+static void sum_children(pyramid_t *self, int k, int x, int y) {
+    const pyramid_level_t *children = &self->levels[k - 1];
+    uint64_t count = 0;
+
+    for (int i = 2 * x; i < 2 * x + 2 && i < children->rows; i++)
+        for (int j = 2 * y; j < 2 * y + 2 && j < children->columns; j++)
+            count += read_count(children, i, j);
+
+    write_count(&self->levels[k], x, y, count);
+}
+
+/**
+ * The cells of the board under a rectangle of blocks, clipped before they are narrowed to ints since the
+ * last block of a large board reaches past INT_MAX
+*/
+static life_bounds_t blocks_cells(pyramid_t *self, int level, life_bounds_t blocks) {
+    long block_size = self->levels[level].block_size;
+    long last_row = (blocks.max_x + 1) * block_size - 1, last_column = (blocks.max_y + 1) * block_size - 1;
+
+    return (life_bounds_t){
+        blocks.min_x * block_size,
+        blocks.min_y * block_size,
+        last_row < self->_board_rows ? last_row : self->_board_rows - 1,
+        last_column < self->_board_columns ? last_column : self->_board_columns - 1,
+    };
+}
+
+static life_bounds_t block_cells(pyramid_t *self, int level, int x, int y) {
+    return blocks_cells(self, level, (life_bounds_t){x, y, x, y});
+}
+
+/**
+ * Live cells in bits first to last of a packed row
+*/
+static uint64_t count_bits(const uint64_t *row, int first, int last) {
+    int first_word = first / 64, last_word = last / 64;
+    uint64_t first_mask = ~(uint64_t)0 << (first % 64);
+    uint64_t last_mask = ~(uint64_t)0 >> (63 - last % 64);
+
+    if (first_word == last_word)
+        return __builtin_popcountll(row[first_word] & first_mask & last_mask);
+
+    uint64_t count = __builtin_popcountll(row[first_word] & first_mask) + __builtin_popcountll(row[last_word] & last_mask);
+    for (int w = first_word + 1; w < last_word; w++)
+        count += __builtin_popcountll(row[w]);
+
+    return count;
+}
+
+/**
+ * Counts a rectangle of blocks straight from the board, packing only the rows and words inside its live bounds
+*/
+static void count_from_board(pyramid_t *self, life_t *life, int level, life_bounds_t blocks, uint64_t *counts) {
+    long block_size = self->levels[level].block_size;
+    int columns = blocks.max_y - blocks.min_y + 1;
+    life_bounds_t cells = bounds_intersect(blocks_cells(self, level, blocks), life->bounds);
+
+    memset(counts, 0, (size_t)(blocks.max_x - blocks.min_x + 1) * columns * sizeof(uint64_t));
+
+    if (bounds_empty(cells))
+        return;
+
+    int first_word = cells.min_y / 64, words = cells.max_y / 64 - first_word + 1;
+    int offset = first_word * 64;
+
+    if (words > self->_row_words) {
+        free(self->_row);
+        self->_row = (uint64_t *)malloc(words * sizeof(uint64_t));
+        if (self->_row == NULL) {
+            error("Unable to allocate memory for density pyramid");
+        }
+        self->_row_words = words;
+    }
+
+    for (int x = cells.min_x; x <= cells.max_x; x++) {
+        uint64_t *row_counts = counts + (size_t)(x / block_size - blocks.min_x) * columns;
+
+        life->pack_row(life, x, first_word, words, self->_row);
+
+        for (int y = cells.min_y / block_size; y <= cells.max_y / block_size; y++) {
+            long first = y * block_size > cells.min_y ? y * block_size : cells.min_y;
+            long last = (y + 1) * block_size - 1 < cells.max_y ? (y + 1) * block_size - 1 : cells.max_y;
+
+            row_counts[y - blocks.min_y] += count_bits(self->_row, first - offset, last - offset);
+        }
+    }
+}
+
+static void set_count(pyramid_t *self, int x, int y, uint64_t count) {
+    pyramid_level_t *first = &self->levels[self->first_level];
+
+    if (count == read_count(first, x, y))
+        return;
+
+    write_count(first, x, y, count);
+
+    for (int k = self->first_level + 1; k < self->num_levels; k++) {
+        x >>= 1;
+        y >>= 1;
+        sum_children(self, k, x, y);
+    }
+}
+
+/**
+ * A stored block is recounted once a tile under it changed since it was counted. Blocks outside the live
+ * bounds are empty without looking at their tiles, so a sparse board only costs the blocks around its cells.
+ * The stale blocks of a row of blocks are counted together, packing each board row once.
+*/
+static void update(pyramid_t *self, life_t *life, life_bounds_t area) {
+    if (life->rows != self->_board_rows || life->columns != self->_board_columns || self->levels == NULL)
+        resize(self, life);
+
+    area = bounds_intersect(area, (life_bounds_t){0, 0, life->rows - 1, life->columns - 1});
+    if (bounds_empty(area))
+        return;
+
+    const pyramid_level_t *first = &self->levels[self->first_level];
+    long block_size = first->block_size;
+    unsigned long counted = life->revision + 1;
+
+    for (int x = area.min_x / block_size; x <= area.max_x / block_size; x++) {
+        unsigned long *revisions = self->_revisions + (size_t)x * first->columns;
+        int first_stale = -1, last_stale = -1;
+
+        for (int y = area.min_y / block_size; y <= area.max_y / block_size; y++) {
+            life_bounds_t cells = block_cells(self, self->first_level, x, y);
+            bool stale = revisions[y] == 0;
+
+            if (revisions[y] == counted)
+                continue;
+
+            if (bounds_empty(bounds_intersect(cells, life->bounds))) {
+                set_count(self, x, y, 0);
+                revisions[y] = counted;
+                continue;
+            }
+
+            for (int i = cells.min_x / life->tile_size; i <= cells.max_x / life->tile_size && !stale; i++)
+                for (int j = cells.min_y / life->tile_size; j <= cells.max_y / life->tile_size && !stale; j++)
+                    stale = life->tile_revisions[(size_t)i * life->tile_columns + j] >= revisions[y];
+
+            if (!stale) {
+                revisions[y] = counted;
+                continue;
+            }
+
+            if (first_stale < 0)
+                first_stale = y;
+            last_stale = y;
+        }
+
+        if (first_stale < 0)
+            continue;
+
+        // Blocks between the stale ones are recounted too, which costs less than packing the rows again
+        count_from_board(self, life, self->first_level, (life_bounds_t){x, first_stale, x, last_stale}, self->_block_counts);
+
+        for (int y = first_stale; y <= last_stale; y++) {
+            set_count(self, x, y, self->_block_counts[y - first_stale]);
+            revisions[y] = counted;
+        }
+    }
+}
+
+static void count_blocks(pyramid_t *self, life_t *life, int level, life_bounds_t blocks, uint64_t *counts) {
+    if (life->rows != self->_board_rows || life->columns != self->_board_columns || self->levels == NULL)
+        resize(self, life);
+
+    if (level < self->first_level) {
+        count_from_board(self, life, level, blocks, counts);
+        return;
+    }
+
+    const pyramid_level_t *stored = &self->levels[level];
+    int columns = blocks.max_y - blocks.min_y + 1;
+
+    self->update(self, life, blocks_cells(self, level, blocks));
+
+    for (int x = blocks.min_x; x <= blocks.max_x; x++)
+        for (int y = blocks.min_y; y <= blocks.max_y; y++)
+            counts[(size_t)(x - blocks.min_x) * columns + y - blocks.min_y] = read_count(stored, x, y);
+}
+
+static uint64_t get_count(pyramid_t *self, int level, int x, int y) {
+    return read_count(&self->levels[level], x, y);
+}
+
+static double get_density(pyramid_t *self, int level, int x, int y) {
+    life_bounds_t cells = block_cells(self, level, x, y);
+    double area = (double)(cells.max_x - cells.min_x + 1) * (cells.max_y - cells.min_y + 1);
+
+    return read_count(&self->levels[level], x, y) / area;
+}
+
+static life_bounds_t find_densest(pyramid_t *self, int level) {
+    int x = 0, y = 0;
+
+    if (level < self->first_level)
+        level = self->first_level;
+
+    for (int k = self->num_levels - 2; k >= level; k--) {
+        const pyramid_level_t *children = &self->levels[k];
+        int best_x = 2 * x, best_y = 2 * y;
+        uint64_t best = 0;
+
+        for (int i = 2 * x; i < 2 * x + 2 && i < children->rows; i++) {
+            for (int j = 2 * y; j < 2 * y + 2 && j < children->columns; j++) {
+                uint64_t count = read_count(children, i, j);
+
+                if (count > best) {
+                    best = count;
+                    best_x = i;
+                    best_y = j;
+                }
+            }
+        }
+
+        x = best_x;
+        y = best_y;
+    }
+
+    return block_cells(self, level, x, y);
+}
+
+pyramid_t *init_pyramid(void) {
+    pyramid_t *self;
+    self = (pyramid_t *)calloc(1, sizeof(pyramid_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for density pyramid.");
+    }
+
+    self->update = update;
+    self->count_blocks = count_blocks;
+    self->get_count = get_count;
+    self->get_density = get_density;
+    self->find_densest = find_densest;
+
+    return self;
+}
+
+void destroy_pyramid(pyramid_t *self) {
+    free_levels(self);
+    free(self->_row);
+    free(self);
+}
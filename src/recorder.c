@@ -0,0 +1,381 @@
+#include "recorder.h"
+
+// Version 02 widened record lengths to 64 bits
+#define RECORDING_MAGIC "SOLREC02"
+#define RECORDING_MAGIC_LENGTH 8
+#define KEYFRAME 'K'
+#define DELTA 'D'
+// Longest LEB128 encoding of a 64 bit value
+#define MAX_VARINT_LENGTH 10
+
+typedef struct recording_header_t {
+    char magic[RECORDING_MAGIC_LENGTH];
+    int32_t rows;
+    int32_t columns;
+    int32_t keyframe_interval;
+} recording_header_t;
+
+typedef struct record_header_t {
+    uint8_t type;
+    // A keyframe of a large noisy board can pass 4 GiB
+    uint64_t length;
+} __attribute__((packed)) record_header_t;
+
+static void reserve(uint8_t **buffer, size_t *buffer_size, size_t size) {
+    if (size <= *buffer_size)
+        return;
+
+    size_t new_size = *buffer_size > 0 ? *buffer_size : 4096;
+    while (new_size < size)
+        new_size *= 2;
+
+    uint8_t *tmp = (uint8_t *)realloc(*buffer, new_size);
+    if (tmp == NULL) {
+        error("Unable to allocate memory for recording buffer");
+    }
+
+    *buffer = tmp;
+    *buffer_size = new_size;
+}
+
+static size_t write_varint(uint8_t *cursor, uint64_t value) {
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        cursor[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    cursor[length++] = (uint8_t)value;
+
+    return length;
+}
+
+static const uint8_t *read_varint(const uint8_t *cursor, const uint8_t *end, uint64_t *value) {
+    int shift = 0;
+    *value = 0;
+
+    while (cursor < end && shift < 64) {
+        uint8_t byte = *cursor++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+
+        if ((byte & 0x80) == 0)
+            return cursor;
+
+        shift += 7;
+    }
+
+    if (shift >= 64)
+        error("Recording is corrupt");
+
+    error("Recording is truncated");
+    return end;
+}
+
+/**
+ * Alternating dead and alive run lengths over the board in row major order, starting with dead
+*/
+static size_t encode_keyframe(recorder_t *self, life_t *life) {
+    size_t length = 0;
+    uint64_t run = 0;
+    bool alive = false;
+
+    for (int i = 0; i < life->rows; i++) {
+        const bool *row = life->grid[i];
+
+        for (int j = 0; j < life->columns; j++) {
+            if (row[j] == alive) {
+                run++;
+                continue;
+            }
+
+            reserve(&self->_buffer, &self->_buffer_size, length + MAX_VARINT_LENGTH);
+            length += write_varint(self->_buffer + length, run);
+            alive = row[j];
+            run = 1;
+        }
+
+        memcpy(&self->_previous[(size_t)i * life->columns], row, life->columns);
+    }
+
+    // A trailing dead run is implied by the board size
+    if (alive) {
+        reserve(&self->_buffer, &self->_buffer_size, length + MAX_VARINT_LENGTH);
+        length += write_varint(self->_buffer + length, run);
+    }
+
+    return length;
+}
+
+/**
+ * Gaps between the indices of the cells that flipped since the last recorded generation
+*/
+static size_t encode_delta(recorder_t *self, life_t *life) {
+    size_t length = 0;
+    uint64_t last_index = 0;
+
+    for (int i = 0; i < life->rows; i++) {
+        const bool *row = life->grid[i];
+        bool *previous = &self->_previous[(size_t)i * life->columns];
+
+        if (memcmp(previous, row, life->columns) == 0)
+            continue;
+
+        for (int j = 0; j < life->columns; j++) {
+            if (previous[j] == row[j])
+                continue;
+
+            uint64_t index = (uint64_t)i * life->columns + j;
+
+            reserve(&self->_buffer, &self->_buffer_size, length + MAX_VARINT_LENGTH);
+            length += write_varint(self->_buffer + length, index - last_index);
+            last_index = index;
+            previous[j] = row[j];
+        }
+    }
+
+    return length;
+}
+
+static void record(recorder_t *self, life_t *life) {
+    if (life->rows != self->rows || life->columns != self->columns)
+        error("Board size changed during recording");
+
+    bool keyframe = self->generation % self->keyframe_interval == 0;
+    record_header_t header;
+
+    header.type = keyframe ? KEYFRAME : DELTA;
+    header.length = keyframe ? encode_keyframe(self, life) : encode_delta(self, life);
+
+    if (fwrite(&header, sizeof(header), 1, self->_file) != 1 ||
+        (header.length > 0 && fwrite(self->_buffer, header.length, 1, self->_file) != 1))
+    {
+        error("Unable to write recording");
+    }
+
+    self->generation++;
+}
+
+recorder_t *init_recorder(const char *file_name, life_t *life, int keyframe_interval) {
+    if (life->grid == NULL) {
+        error("Recording needs a board held in memory");
+    }
+
+    recorder_t *self;
+    self = (recorder_t *)calloc(1, sizeof(recorder_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for recorder.");
+    }
+
+    self->_file = fopen(file_name, "wb");
+    if (self->_file == NULL) {
+        error(str_concat("Unable to open recording ", file_name));
+    }
+
+    self->rows = life->rows;
+    self->columns = life->columns;
+    self->keyframe_interval = keyframe_interval > 0 ? keyframe_interval : 1;
+    self->generation = 0;
+    self->record = record;
+
+    self->_previous = (bool *)calloc((size_t)self->rows * self->columns, sizeof(bool));
+    if (self->_previous == NULL) {
+        error("Unable to allocate memory for recorder.");
+    }
+
+    recording_header_t header = {RECORDING_MAGIC, self->rows, self->columns, self->keyframe_interval};
+    if (fwrite(&header, sizeof(header), 1, self->_file) != 1) {
+        error(str_concat("Unable to write recording ", file_name));
+    }
+
+    return self;
+}
+
+void destroy_recorder(recorder_t *self) {
+    fclose(self->_file);
+    free(self->_previous);
+    free(self->_buffer);
+    free(self);
+}
+
+static bool read_record(player_t *self, record_header_t *header) {
+    if (fread(header, sizeof(*header), 1, self->_file) != 1)
+        return false;
+
+    reserve(&self->_buffer, &self->_buffer_size, header->length);
+
+    if (header->length > 0 && fread(self->_buffer, header->length, 1, self->_file) != 1)
+        error("Recording is truncated");
+
+    return true;
+}
+
+static void apply_keyframe(player_t *self, life_t *life, size_t length) {
+    const uint8_t *cursor = self->_buffer;
+    const uint8_t *end = self->_buffer + length;
+    uint64_t index = 0, cells = (uint64_t)life->rows * life->columns;
+    bool alive = false;
+
+    for (int i = 0; i < life->rows; i++)
+        memset(life->grid[i], false, life->columns);
+
+    while (cursor < end) {
+        uint64_t run;
+        cursor = read_varint(cursor, end, &run);
+
+        if (run > cells - index)
+            error("Recording is corrupt, a keyframe runs past the board");
+
+        // Live runs can wrap over several rows
+        for (uint64_t remaining = alive ? run : 0; remaining > 0;) {
+            uint64_t row = (index + run - remaining) / life->columns;
+            uint64_t column = (index + run - remaining) % life->columns;
+            uint64_t count = life->columns - column < remaining ? life->columns - column : remaining;
+
+            memset(&life->grid[row][column], true, count);
+            remaining -= count;
+        }
+
+        index += run;
+        alive = !alive;
+    }
+}
+
+static void apply_delta(player_t *self, life_t *life, size_t length) {
+    const uint8_t *cursor = self->_buffer;
+    const uint8_t *end = self->_buffer + length;
+    uint64_t index = 0, cells = (uint64_t)life->rows * life->columns;
+
+    while (cursor < end) {
+        uint64_t gap;
+        cursor = read_varint(cursor, end, &gap);
+
+        // Compared before adding, so a huge gap cannot wrap the index back onto the board
+        if (gap >= cells - index)
+            error("Recording is corrupt, a delta flips a cell past the board");
+        index += gap;
+
+        bool *cell = &life->grid[index / life->columns][index % life->columns];
+        *cell = !*cell;
+    }
+}
+
+static bool apply_next(player_t *self, life_t *life) {
+    record_header_t header;
+
+    if (self->generation + 1 >= self->generations || !read_record(self, &header))
+        return false;
+
+    if (header.type == KEYFRAME)
+        apply_keyframe(self, life, header.length);
+    else
+        apply_delta(self, life, header.length);
+
+    self->generation++;
+    return true;
+}
+
+static bool step(player_t *self, life_t *life) {
+    if (!apply_next(self, life))
+        return false;
+
+    life->refresh(life);
+    return true;
+}
+
+static void seek(player_t *self, life_t *life, long generation) {
+    if (generation < 0)
+        generation = 0;
+    if (generation >= self->generations)
+        generation = self->generations - 1;
+
+    // Stepping forward is cheaper than reloading while no keyframe lies in between
+    int keyframe = 0;
+    while (keyframe + 1 < self->_num_keyframes && self->_keyframe_generations[keyframe + 1] <= generation)
+        keyframe++;
+
+    if (generation < self->generation || self->generation < self->_keyframe_generations[keyframe]) {
+        fseek(self->_file, self->_keyframe_offsets[keyframe], SEEK_SET);
+        self->generation = self->_keyframe_generations[keyframe] - 1;
+    }
+
+    while (self->generation < generation && apply_next(self, life))
+        ;
+
+    life->refresh(life);
+}
+
+/**
+ * Walks the record headers once to find where every keyframe starts
+*/
+static void index_recording(player_t *self) {
+    record_header_t header;
+    int capacity = 16;
+
+    self->_keyframe_generations = (long *)malloc(capacity * sizeof(long));
+    self->_keyframe_offsets = (long *)malloc(capacity * sizeof(long));
+
+    long offset = ftell(self->_file);
+
+    while (fread(&header, sizeof(header), 1, self->_file) == 1) {
+        if (header.type == KEYFRAME) {
+            if (self->_num_keyframes == capacity) {
+                capacity *= 2;
+                self->_keyframe_generations = (long *)realloc(self->_keyframe_generations, capacity * sizeof(long));
+                self->_keyframe_offsets = (long *)realloc(self->_keyframe_offsets, capacity * sizeof(long));
+            }
+
+            if (self->_keyframe_generations == NULL || self->_keyframe_offsets == NULL)
+                error("Unable to allocate memory for recording index");
+
+            self->_keyframe_generations[self->_num_keyframes] = self->generations;
+            self->_keyframe_offsets[self->_num_keyframes] = offset;
+            self->_num_keyframes++;
+        }
+
+        offset += sizeof(header) + header.length;
+        fseek(self->_file, offset, SEEK_SET);
+        self->generations++;
+    }
+
+    if (self->_num_keyframes == 0)
+        error("Recording has no keyframes");
+}
+
+player_t *init_player(const char *file_name) {
+    player_t *self;
+    self = (player_t *)calloc(1, sizeof(player_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for player.");
+    }
+
+    self->_file = fopen(file_name, "rb");
+    if (self->_file == NULL) {
+        error(str_concat("Unable to open recording ", file_name));
+    }
+
+    recording_header_t header;
+    if (fread(&header, sizeof(header), 1, self->_file) != 1 ||
+        memcmp(header.magic, RECORDING_MAGIC, RECORDING_MAGIC_LENGTH) != 0)
+    {
+        error(str_concat("Not a recording: ", file_name));
+    }
+
+    self->rows = header.rows;
+    self->columns = header.columns;
+    self->generation = -1;
+    self->seek = seek;
+    self->step = step;
+
+    index_recording(self);
+    fseek(self->_file, self->_keyframe_offsets[0], SEEK_SET);
+
+    return self;
+}
+
+void destroy_player(player_t *self) {
+    fclose(self->_file);
+    free(self->_keyframe_generations);
+    free(self->_keyframe_offsets);
+    free(self->_buffer);
+    free(self);
+}
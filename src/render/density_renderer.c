@@ -0,0 +1,180 @@
+#include "render/renderer.h"
+
+typedef struct density_renderer_t {
+    unsigned int VAO;
+    unsigned int texture;
+    int texture_rows;
+    int texture_columns;
+    pyramid_t *pyramid;
+    upload_ring_t *ring;
+    uint64_t *counts;
+    size_t counts_size;
+    // What the texture holds, so an unchanged board seen from the same place isn't counted again
+    unsigned long drawn_revision;
+    int drawn_level;
+    life_bounds_t drawn_blocks;
+} density_renderer_t;
+
+/**
+ * The smallest blocks at least a pixel wide, so every block lands on a pixel of its own or shares one
+ * with its neighbours, and none is skipped over
+*/
+static int pick_level(pyramid_t *pyramid, float cell_width) {
+    int level = 0;
+
+    while (level < pyramid->num_levels - 1 && pyramid->levels[level].block_size * cell_width < 1.0f)
+        level++;
+
+    return level;
+}
+
+static void resize_texture(density_renderer_t *state, int rows, int columns) {
+    if (rows <= state->texture_rows && columns <= state->texture_columns)
+        return;
+
+    state->texture_rows = rows > state->texture_rows ? rows : state->texture_rows;
+    state->texture_columns = columns > state->texture_columns ? columns : state->texture_columns;
+
+    glDeleteTextures(1, &state->texture);
+    glGenTextures(1, &state->texture);
+    glBindTexture(GL_TEXTURE_2D, state->texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, state->texture_columns, state->texture_rows);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+/**
+ * Fills the texture with the density of each block, ceil'd so a block with any live cell is never blank
+*/
+static void upload_blocks(density_renderer_t *state, life_t *life, int level, life_bounds_t blocks) {
+    pyramid_t *pyramid = state->pyramid;
+    long block_size = pyramid->levels[level].block_size;
+    int rows = blocks.max_x - blocks.min_x + 1, columns = blocks.max_y - blocks.min_y + 1;
+    size_t count = (size_t)rows * columns;
+
+    if (count > state->counts_size) {
+        free(state->counts);
+        state->counts = (uint64_t *)malloc(count * sizeof(uint64_t));
+        if (state->counts == NULL) {
+            error("Unable to allocate memory for block densities");
+        }
+        state->counts_size = count;
+    }
+
+    pyramid->count_blocks(pyramid, life, level, blocks, state->counts);
+
+    size_t offset;
+    uint8_t *densities = (uint8_t *)state->ring->begin(state->ring, count, &offset);
+
+    for (int x = 0; x < rows; x++) {
+        long first_row = (blocks.min_x + x) * block_size;
+        long height = (first_row + block_size < life->rows ? first_row + block_size : life->rows) - first_row;
+
+        for (int y = 0; y < columns; y++) {
+            long first_column = (blocks.min_y + y) * block_size;
+            long width = (first_column + block_size < life->columns ? first_column + block_size : life->columns) - first_column;
+            double density = state->counts[(size_t)x * columns + y] / ((double)height * width);
+
+            densities[(size_t)x * columns + y] = (uint8_t)ceil(density * 255.0);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns, rows, GL_RED, GL_UNSIGNED_BYTE, (void *)offset);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    state->ring->end(state->ring);
+}
+
+/**
+ * Only the blocks in view are counted and uploaded, which is about one per pixel whatever the size of the board
+*/
+static void draw(renderer_t *self, life_t *life) {
+    density_renderer_t *state = (density_renderer_t *)self->_state;
+    pyramid_t *pyramid = state->pyramid;
+    shader_t *shader = self->shader;
+
+    life_bounds_t cells = visible_cells(&self->view, life->rows, life->columns);
+    if (bounds_empty(cells))
+        return;
+
+    // Levels are only laid out once the pyramid has seen the board
+    if (pyramid->levels == NULL || pyramid->_board_rows != life->rows || pyramid->_board_columns != life->columns)
+        pyramid->update(pyramid, life, (life_bounds_t){0, 0, -1, -1});
+
+    int level = pick_level(pyramid, self->view.cell_width);
+    long block_size = pyramid->levels[level].block_size;
+    life_bounds_t blocks = {
+        cells.min_x / block_size, cells.min_y / block_size,
+        cells.max_x / block_size, cells.max_y / block_size,
+    };
+    int rows = blocks.max_x - blocks.min_x + 1, columns = blocks.max_y - blocks.min_y + 1;
+    bool resized = rows > state->texture_rows || columns > state->texture_columns;
+
+    glActiveTexture(GL_TEXTURE0);
+    resize_texture(state, rows, columns);
+    glBindTexture(GL_TEXTURE_2D, state->texture);
+
+    if (resized || life->revision != state->drawn_revision || level != state->drawn_level ||
+        memcmp(&blocks, &state->drawn_blocks, sizeof(life_bounds_t)) != 0) {
+        upload_blocks(state, life, level, blocks);
+
+        state->drawn_revision = life->revision;
+        state->drawn_level = level;
+        state->drawn_blocks = blocks;
+    }
+
+    use_renderer(self);
+    shader->setUniformFloat(shader, "blockSize", (float)block_size);
+    shader->setUniformV2F(shader, "firstBlock", (float)blocks.min_x, (float)blocks.min_y);
+    shader->setUniformV2F(shader, "numBlocks", (float)rows, (float)columns);
+    shader->setUniformV2F(shader, "boardSize", (float)life->rows, (float)life->columns);
+    glBindVertexArray(state->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void destroy(renderer_t *self) {
+    density_renderer_t *state = (density_renderer_t *)self->_state;
+
+    glDeleteTextures(1, &state->texture);
+    glDeleteVertexArrays(1, &state->VAO);
+
+    destroy_upload_ring(state->ring);
+    destroy_pyramid(state->pyramid);
+    free(state->counts);
+    free(state);
+}
+
+renderer_t *init_density_renderer(bool any_alive) {
+    renderer_t *self;
+    self = (renderer_t *)calloc(1, sizeof(renderer_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for renderer.");
+    }
+
+    density_renderer_t *state = (density_renderer_t *)calloc(1, sizeof(density_renderer_t));
+    if (state == NULL) {
+        error("Unable to allocate memory for renderer.");
+    }
+
+    state->pyramid = init_pyramid();
+    state->drawn_level = -1;
+
+    self->shader = init_shader("board.vert", "density.frag");
+    self->shader->use(self->shader);
+    self->shader->setUniformInt(self->shader, "blocks", 0);
+    self->shader->setUniformBool(self->shader, "anyAlive", any_alive);
+
+    state->ring = init_upload_ring(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    glGenVertexArrays(1, &state->VAO);
+
+    init_view_block(self);
+
+    self->_state = state;
+    self->draw = draw;
+    self->_destroy = destroy;
+
+    return self;
+}
@@ -0,0 +1,214 @@
+#include "render/renderer.h"
+
+static float vertices[] = {
+   0.5f, 0.5f 
+};
+
+static struct uniforms_t {
+    const char *accelerate;
+    const char *instanced;
+    const char *cell;
+    const char *view;
+} uniforms = {
+    "accelerate",
+    "instanced",
+    "cell",
+    "view"
+};
+
+typedef struct point_renderer_t {
+    unsigned int VAO;
+    unsigned int VBO;
+    bool accelerate;
+    bool instanced;
+    // Row and column of every live cell, one instance each
+    upload_ring_t *ring;
+} point_renderer_t;
+
+/**
+ * Dead cells are the board's rectangle cleared to the dead color, the pixels whose centers a point sprite
+ * covering the same cells would have
+*/
+static void clear_board(renderer_t *self, life_t *life) {
+    const renderer_view_t *view = &self->view;
+    int left = (int)ceilf(view->width / 2.0f - view->grid_center[1] * view->cell_width - 0.5f);
+    int right = (int)ceilf(view->width / 2.0f + (life->columns - view->grid_center[1]) * view->cell_width - 0.5f);
+    int bottom = (int)ceilf(view->height / 2.0f - view->grid_center[0] * view->cell_width - 0.5f);
+    int top = (int)ceilf(view->height / 2.0f + (life->rows - view->grid_center[0]) * view->cell_width - 0.5f);
+
+    left = left > 0 ? left : 0;
+    bottom = bottom > 0 ? bottom : 0;
+    right = right < view->width ? right : view->width;
+    top = top < view->height ? top : view->height;
+
+    if (left >= right || bottom >= top)
+        return;
+
+    GLfloat clear_color[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(left, bottom, right - left, top - bottom);
+    glClearColor(view->dead_color[0], view->dead_color[1], view->dead_color[2], 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+/**
+ * Gathers up to capacity live cells from packed rows, only the visible part of the live bounds has any worth drawing
+*/
+static size_t gather_cells(life_t *life, life_bounds_t visible, int *cells, size_t capacity) {
+    life_bounds_t bounds = bounds_intersect(life->bounds, visible);
+    size_t count = 0;
+
+    if (bounds_empty(bounds))
+        return 0;
+
+    int first_word = bounds.min_y / 64, words = bounds.max_y / 64 - first_word + 1;
+
+    uint64_t *bits = (uint64_t *)malloc(words * sizeof(uint64_t));
+    if (bits == NULL) {
+        error("Unable to allocate memory for cell instances");
+    }
+
+    for (int i = bounds.min_x; i <= bounds.max_x; i++) {
+        life->pack_row(life, i, first_word, words, bits);
+
+        for (int w = 0; w < words; w++) {
+            for (uint64_t word = bits[w]; word != 0 && count < capacity; word &= word - 1) {
+                int column = (first_word + w) * 64 + __builtin_ctzll(word);
+                if (column < bounds.min_y || column > bounds.max_y)
+                    continue;
+
+                cells[count * 2] = i;
+                cells[count * 2 + 1] = column;
+                count++;
+            }
+        }
+    }
+
+    free(bits);
+
+    return count;
+}
+
+/**
+ * The population is exact, so the cells are written straight into the ring without counting them first
+*/
+static void draw_instanced(renderer_t *self, life_t *life) {
+    point_renderer_t *state = (point_renderer_t *)self->_state;
+    size_t capacity = life->stats.population > 0 ? life->stats.population : 1;
+    size_t offset;
+    int *cells = (int *)state->ring->begin(state->ring, capacity * 2 * sizeof(int), &offset);
+    size_t count = gather_cells(life, visible_cells(&self->view, life->rows, life->columns), cells, capacity);
+
+    clear_board(self, life);
+
+    glVertexAttribIPointer(1, 2, GL_INT, 2 * sizeof(int), (void *)offset);
+    if (count > 0)
+        glDrawArraysInstanced(GL_POINTS, 0, 1, count);
+
+    state->ring->end(state->ring);
+}
+
+static void draw(renderer_t *self, life_t *life) {
+    point_renderer_t *state = (point_renderer_t *)self->_state;
+    shader_t *shader = self->shader;
+
+    use_renderer(self);
+    glBindVertexArray(state->VAO);
+
+    if (state->instanced) {
+        draw_instanced(self, life);
+        return;
+    }
+
+    life_bounds_t visible = visible_cells(&self->view, life->rows, life->columns);
+    // Looked up once rather than for every cell
+    int cell = shader->getUniformLocation(shader, uniforms.cell);
+    int view_location = state->accelerate ? -1 : shader->getUniformLocation(shader, uniforms.view);
+
+    for (int i = visible.min_x; i <= visible.max_x; i++) {
+        for (int j = visible.min_y; j <= visible.max_y; j++) {
+            if (!state->accelerate) {
+                mat4 view;
+                glm_mat4_identity(view);
+                glm_translate(view, (vec3){j - self->view.grid_center[1], i - self->view.grid_center[0], -1.0f});
+                glUniformMatrix4fv(view_location, 1, GL_FALSE, (float *)view);
+            }
+
+            glUniform3f(cell, (float)i, (float)j, (float)life->get_alive(life, i , j));
+            glDrawArrays(GL_POINTS, 0, 1);
+        }
+    }
+}
+
+static void destroy(renderer_t *self) {
+    point_renderer_t *state = (point_renderer_t *)self->_state;
+
+    glDisableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    glDeleteBuffers(1, &state->VBO);
+    glDeleteVertexArrays(1, &state->VAO);
+
+    if (state->ring != NULL)
+        destroy_upload_ring(state->ring);
+    free(state);
+}
+
+static renderer_t *init_renderer(bool accelerate, bool instanced) {
+    renderer_t *self;
+    self = (renderer_t *)calloc(1, sizeof(renderer_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for renderer.");
+    }
+
+    point_renderer_t *state = (point_renderer_t *)calloc(1, sizeof(point_renderer_t));
+    if (state == NULL) {
+        error("Unable to allocate memory for renderer.");
+    }
+
+    state->accelerate = accelerate;
+    state->instanced = instanced;
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
+    self->shader = init_shader("cell.vert", "cell.frag");
+    self->shader->use(self->shader);
+    self->shader->setUniformBool(self->shader, uniforms.accelerate, accelerate);
+    self->shader->setUniformBool(self->shader, uniforms.instanced, instanced);
+    init_view_block(self);
+
+    glGenVertexArrays(1, &state->VAO);
+    glBindVertexArray(state->VAO);
+
+    glGenBuffers(1, &state->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, state->VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+
+    if (instanced) {
+        // The attribute is pointed at the slot being drawn every frame
+        state->ring = init_upload_ring(GL_ARRAY_BUFFER, 0);
+        glVertexAttribIPointer(1, 2, GL_INT, 2 * sizeof(int), (void *)0);
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(1);
+    }
+
+    self->_state = state;
+    self->draw = draw;
+    self->_destroy = destroy;
+
+    return self;
+}
+
+renderer_t *init_point_renderer(bool accelerate) {
+    return init_renderer(accelerate, false);
+}
+
+renderer_t *init_instanced_renderer(void) {
+    return init_renderer(true, true);
+}
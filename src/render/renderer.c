@@ -0,0 +1,78 @@
+#include "render/renderer.h"
+#include <stddef.h>
+
+_Static_assert(offsetof(renderer_view_block_t, alive_color) == 64 && offsetof(renderer_view_block_t, grid_center) == 96 &&
+               offsetof(renderer_view_block_t, cell_width) == 112 && sizeof(renderer_view_block_t) == 128,
+               "renderer_view_block_t has to match the std140 View block");
+
+static void set_view(renderer_t *self, const renderer_view_t *view) {
+    renderer_view_block_t block;
+    float half_width = view->width / view->cell_width / 2.0f;
+    float half_height = view->height / view->cell_width / 2.0f;
+
+    self->view = *view;
+
+    glm_ortho(-half_width, half_width, -half_height, half_height, 0.0f, 100.0f, block.projection);
+    for (int i = 0; i < 3; i++) {
+        block.alive_color[i] = view->alive_color[i];
+        block.dead_color[i] = view->dead_color[i];
+    }
+
+    block.alive_color[3] = 1.0f;
+    block.dead_color[3] = 1.0f;
+    block.grid_center[0] = view->grid_center[0];
+    block.grid_center[1] = view->grid_center[1];
+    block.viewport[0] = (float)view->width;
+    block.viewport[1] = (float)view->height;
+    block.cell_width = view->cell_width;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, self->view_buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+}
+
+void init_view_block(renderer_t *self) {
+    self->shader->bindUniformBlock(self->shader, "View", RENDERER_VIEW_BINDING);
+
+    glGenBuffers(1, &self->view_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, self->view_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(renderer_view_block_t), NULL, GL_DYNAMIC_DRAW);
+
+    self->set_view = set_view;
+}
+
+void use_renderer(renderer_t *self) {
+    self->shader->use(self->shader);
+    glBindBufferBase(GL_UNIFORM_BUFFER, RENDERER_VIEW_BINDING, self->view_buffer);
+}
+
+void destroy_renderer(renderer_t *self) {
+    self->_destroy(self);
+    glDeleteBuffers(1, &self->view_buffer);
+    destroy_shader(self->shader);
+    free(self);
+}
+
+/**
+ * Clamped while still floats, a view far off the board would overflow an int
+*/
+static int clamp_cell(float cell, int size) {
+    if (cell < -1.0f)
+        return -1;
+    if (cell > (float)size)
+        return size;
+    return (int)cell;
+}
+
+life_bounds_t visible_cells(const renderer_view_t *view, int rows, int columns) {
+    float half_height = view->height / (2.0f * view->cell_width);
+    float half_width = view->width / (2.0f * view->cell_width);
+
+    life_bounds_t cells = {
+        clamp_cell(floorf(view->grid_center[0] - half_height), rows),
+        clamp_cell(floorf(view->grid_center[1] - half_width), columns),
+        clamp_cell(floorf(view->grid_center[0] + half_height), rows),
+        clamp_cell(floorf(view->grid_center[1] + half_width), columns),
+    };
+
+    return bounds_intersect(cells, (life_bounds_t){0, 0, rows - 1, columns - 1});
+}
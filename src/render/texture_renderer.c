@@ -0,0 +1,338 @@
+#include "render/renderer.h"
+
+/**
+ * Rows first_row to last_row and 64 cell words first_word to last_word of the board, in tiles
+*/
+typedef struct texture_span_t {
+    int first_row;
+    int last_row;
+    int first_word;
+    int last_word;
+} texture_span_t;
+
+/**
+ * The texture only holds the tiles around the view. Board tile (r, c) goes in slot (r % tile_rows, c % tile_columns),
+ * so panning uploads just the tiles that come into view. These tiles are always LIFE_TILE_SIZE rows by one word,
+ * whatever size of tile the board tracks revisions for.
+*/
+typedef struct texture_renderer_t {
+    unsigned int VAO;
+    unsigned int texture;
+    int max_size;
+    int tile_rows;
+    int tile_columns;
+    // Board tile in each slot, -1 for none, and the board revision it was uploaded at
+    long *slot_tiles;
+    unsigned long *slot_revisions;
+    int board_rows;
+    int board_columns;
+    // Rows are packed 64 cells to a word straight into the ring, and read by the texture as pairs of 32 bit texels
+    upload_ring_t *ring;
+    texture_span_t *spans;
+    size_t spans_capacity;
+} texture_renderer_t;
+
+/**
+ * Tiles a window of cells can overlap at once from any position, rounded up to a power of two so the
+ * shader can wrap with a mask
+*/
+static int tiles_across(float cells, int limit) {
+    float needed = ceilf((cells + 1.0f) / LIFE_TILE_SIZE) + 1.0f;
+    int tiles = 1;
+
+    while (tiles < limit && (float)tiles < needed)
+        tiles *= 2;
+
+    return tiles;
+}
+
+/**
+ * Immutable storage can't be resized, so a new view size or a board that grew gets a new texture.
+ * A board that grew has moved its cells, so every slot is emptied either way.
+*/
+static void resize_texture(renderer_t *self, life_t *life) {
+    texture_renderer_t *state = (texture_renderer_t *)self->_state;
+    const renderer_view_t *view = &self->view;
+    int tile_rows = tiles_across(view->height / view->cell_width, (life->rows + LIFE_TILE_SIZE - 1) / LIFE_TILE_SIZE);
+    int tile_columns = tiles_across(view->width / view->cell_width, (life->columns + LIFE_TILE_SIZE - 1) / LIFE_TILE_SIZE);
+
+    while (tile_rows > 1 && tile_rows * LIFE_TILE_SIZE > state->max_size)
+        tile_rows /= 2;
+    while (tile_columns > 1 && tile_columns * 2 > state->max_size)
+        tile_columns /= 2;
+
+    bool same_board = life->rows == state->board_rows && life->columns == state->board_columns;
+    if (same_board && tile_rows == state->tile_rows && tile_columns == state->tile_columns)
+        return;
+
+    size_t slots = (size_t)tile_rows * tile_columns;
+    if (tile_rows != state->tile_rows || tile_columns != state->tile_columns) {
+        free(state->slot_tiles);
+        free(state->slot_revisions);
+        state->slot_tiles = (long *)malloc(slots * sizeof(long));
+        state->slot_revisions = (unsigned long *)malloc(slots * sizeof(unsigned long));
+        if (state->slot_tiles == NULL || state->slot_revisions == NULL) {
+            error("Unable to allocate memory for board texture");
+        }
+
+        glDeleteTextures(1, &state->texture);
+        glGenTextures(1, &state->texture);
+        glBindTexture(GL_TEXTURE_2D, state->texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, tile_columns * 2, tile_rows * LIFE_TILE_SIZE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    for (size_t i = 0; i < slots; i++)
+        state->slot_tiles[i] = -1;
+
+    state->tile_rows = tile_rows;
+    state->tile_columns = tile_columns;
+    state->board_rows = life->rows;
+    state->board_columns = life->columns;
+}
+
+static void add_span(texture_renderer_t *state, size_t *count, texture_span_t span) {
+    if (*count == state->spans_capacity) {
+        state->spans_capacity = state->spans_capacity > 0 ? state->spans_capacity * 2 : 64;
+        state->spans = (texture_span_t *)realloc(state->spans, state->spans_capacity * sizeof(texture_span_t));
+        if (state->spans == NULL) {
+            error("Unable to allocate memory for board texture");
+        }
+    }
+
+    state->spans[(*count)++] = span;
+}
+
+static long tile_id(life_t *life, int r, int c) {
+    return (long)r * ((life->columns + LIFE_TILE_SIZE - 1) / LIFE_TILE_SIZE) + c;
+}
+
+static bool needs_upload(texture_renderer_t *state, life_t *life, int r, int c) {
+    size_t slot = (size_t)(r % state->tile_rows) * state->tile_columns + c % state->tile_columns;
+    int scale = life->tile_size / LIFE_TILE_SIZE;
+    unsigned long revision = life->tile_revisions[(size_t)(r / scale) * life->tile_columns + c / scale];
+
+    return state->slot_tiles[slot] != tile_id(life, r, c) || revision > state->slot_revisions[slot];
+}
+
+/**
+ * Runs of tiles to upload along each row of visible tiles, a run directly below one covering the same
+ * columns joins it. Runs stop where the slots wrap around. Returns the number of spans and adds up the
+ * words they hold.
+*/
+static size_t find_spans(texture_renderer_t *state, life_t *life, life_bounds_t tiles, size_t *words) {
+    size_t count = 0, previous = 0, previous_end = 0;
+
+    *words = 0;
+
+    for (int r = tiles.min_x; r <= tiles.max_x; r++) {
+        size_t row_start = count, match = previous;
+
+        // A span can't carry across the wrap either
+        if (r % state->tile_rows == 0)
+            previous_end = previous;
+
+        for (int c = tiles.min_y; c <= tiles.max_y; c++) {
+            if (!needs_upload(state, life, r, c))
+                continue;
+
+            int first = c;
+            while (c + 1 <= tiles.max_y && (c + 1) % state->tile_columns != 0 && needs_upload(state, life, r, c + 1))
+                c++;
+
+            while (match < previous_end && state->spans[match].first_word < first)
+                match++;
+
+            if (match < previous_end && state->spans[match].first_word == first && state->spans[match].last_word == c) {
+                // Moved to the end so the spans of this row of tiles stay together and in order
+                texture_span_t span = state->spans[match];
+                span.last_row = r;
+                state->spans[match].first_row = -1;
+                add_span(state, &count, span);
+            } else {
+                add_span(state, &count, (texture_span_t){r, r, first, c});
+            }
+        }
+
+        previous = row_start;
+        previous_end = count;
+    }
+
+    // Drop the spans that were carried down
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        texture_span_t span = state->spans[i];
+        if (span.first_row < 0)
+            continue;
+
+        int last_row = (span.last_row + 1) * LIFE_TILE_SIZE < life->rows ? (span.last_row + 1) * LIFE_TILE_SIZE : life->rows;
+        *words += (size_t)(last_row - span.first_row * LIFE_TILE_SIZE) * (span.last_word - span.first_word + 1);
+        state->spans[kept++] = span;
+    }
+
+    return kept;
+}
+
+/**
+ * The visible tiles, cut down around the middle of the view if the texture can't hold them all
+*/
+static life_bounds_t visible_tiles(texture_renderer_t *state, const renderer_view_t *view, life_t *life) {
+    life_bounds_t cells = visible_cells(view, life->rows, life->columns);
+
+    if (bounds_empty(cells))
+        return cells;
+
+    life_bounds_t tiles = {
+        cells.min_x / LIFE_TILE_SIZE, cells.min_y / LIFE_TILE_SIZE,
+        cells.max_x / LIFE_TILE_SIZE, cells.max_y / LIFE_TILE_SIZE,
+    };
+
+    if (tiles.max_x - tiles.min_x + 1 > state->tile_rows) {
+        tiles.min_x = (tiles.min_x + tiles.max_x - state->tile_rows + 1) / 2;
+        tiles.max_x = tiles.min_x + state->tile_rows - 1;
+    }
+    if (tiles.max_y - tiles.min_y + 1 > state->tile_columns) {
+        tiles.min_y = (tiles.min_y + tiles.max_y - state->tile_columns + 1) / 2;
+        tiles.max_y = tiles.min_y + state->tile_columns - 1;
+    }
+
+    return tiles;
+}
+
+/**
+ * A board computed on the GPU already is a texture in the same format, holding all of the board
+*/
+static void draw_gpu_board(renderer_t *self, life_t *life) {
+    texture_renderer_t *state = (texture_renderer_t *)self->_state;
+    shader_t *shader = self->shader;
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, life->texture);
+
+    use_renderer(self);
+    shader->setUniformBool(shader, "windowed", false);
+    shader->setUniformV4F(shader, "resident", 0.0f, 0.0f, (float)life->rows, (float)life->columns);
+    glBindVertexArray(state->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+/**
+ * Only the visible tiles that changed since they were last uploaded, or were not in the texture, are
+ * packed and uploaded, one glTexSubImage2D per span
+*/
+static void draw(renderer_t *self, life_t *life) {
+    texture_renderer_t *state = (texture_renderer_t *)self->_state;
+    shader_t *shader = self->shader;
+
+    if (life->texture != 0) {
+        draw_gpu_board(self, life);
+        return;
+    }
+
+    resize_texture(self, life);
+
+    life_bounds_t tiles = visible_tiles(state, &self->view, life);
+    if (bounds_empty(tiles))
+        return;
+
+    size_t words;
+    size_t num_spans = find_spans(state, life, tiles, &words);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, state->texture);
+
+    if (num_spans > 0) {
+        size_t offset;
+        uint64_t *cells = (uint64_t *)state->ring->begin(state->ring, words * sizeof(uint64_t), &offset);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        for (size_t k = 0; k < num_spans; k++) {
+            texture_span_t span = state->spans[k];
+            int first_row = span.first_row * LIFE_TILE_SIZE;
+            int last_row = (span.last_row + 1) * LIFE_TILE_SIZE < life->rows ? (span.last_row + 1) * LIFE_TILE_SIZE - 1 : life->rows - 1;
+            int num_words = span.last_word - span.first_word + 1;
+            size_t size = (size_t)(last_row - first_row + 1) * num_words;
+
+            for (int i = first_row; i <= last_row; i++)
+                life->pack_row(life, i, span.first_word, num_words, cells + (size_t)(i - first_row) * num_words);
+
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, num_words * 2);
+            glTexSubImage2D(GL_TEXTURE_2D, 0,
+                            span.first_word % state->tile_columns * 2, span.first_row % state->tile_rows * LIFE_TILE_SIZE,
+                            num_words * 2, last_row - first_row + 1,
+                            GL_RED_INTEGER, GL_UNSIGNED_INT, (void *)offset);
+
+            for (int r = span.first_row; r <= span.last_row; r++) {
+                for (int c = span.first_word; c <= span.last_word; c++) {
+                    size_t slot = (size_t)(r % state->tile_rows) * state->tile_columns + c % state->tile_columns;
+                    state->slot_tiles[slot] = tile_id(life, r, c);
+                    state->slot_revisions[slot] = life->revision;
+                }
+            }
+
+            cells += size;
+            offset += size * sizeof(uint64_t);
+        }
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        state->ring->end(state->ring);
+    }
+
+    use_renderer(self);
+    shader->setUniformBool(shader, "windowed", true);
+    shader->setUniformV4F(shader, "resident",
+        (float)(tiles.min_x * LIFE_TILE_SIZE), (float)(tiles.min_y * LIFE_TILE_SIZE),
+        (float)((tiles.max_x + 1) * LIFE_TILE_SIZE < life->rows ? (tiles.max_x + 1) * LIFE_TILE_SIZE : life->rows),
+        (float)((tiles.max_y + 1) * LIFE_TILE_SIZE < life->columns ? (tiles.max_y + 1) * LIFE_TILE_SIZE : life->columns));
+    glBindVertexArray(state->VAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void destroy(renderer_t *self) {
+    texture_renderer_t *state = (texture_renderer_t *)self->_state;
+
+    glDeleteTextures(1, &state->texture);
+    glDeleteVertexArrays(1, &state->VAO);
+
+    destroy_upload_ring(state->ring);
+    free(state->slot_tiles);
+    free(state->slot_revisions);
+    free(state->spans);
+    free(state);
+}
+
+renderer_t *init_texture_renderer(void) {
+    renderer_t *self;
+    self = (renderer_t *)calloc(1, sizeof(renderer_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for renderer.");
+    }
+
+    texture_renderer_t *state = (texture_renderer_t *)calloc(1, sizeof(texture_renderer_t));
+    if (state == NULL) {
+        error("Unable to allocate memory for renderer.");
+    }
+
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &state->max_size);
+
+    self->shader = init_shader("board.vert", "board.frag");
+    self->shader->use(self->shader);
+    self->shader->setUniformInt(self->shader, "board", 0);
+
+    state->ring = init_upload_ring(GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // The triangle comes from gl_VertexID, but core profile still wants a vertex array bound to draw
+    glGenVertexArrays(1, &state->VAO);
+
+    init_view_block(self);
+
+    self->_state = state;
+    self->draw = draw;
+    self->_destroy = destroy;
+
+    return self;
+}
@@ -0,0 +1,89 @@
+#include "render/upload_ring.h"
+
+#define SLOT_ALIGNMENT 256
+#define PERSISTENT_FLAGS (GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT)
+
+static void wait_for(GLsync *fence) {
+    if (*fence == NULL)
+        return;
+
+    for (;;) {
+        GLenum status = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            break;
+        if (status == GL_WAIT_FAILED)
+            error("Unable to wait for the GPU to finish with an upload slot");
+    }
+
+    glDeleteSync(*fence);
+    *fence = NULL;
+}
+
+/**
+ * Storage made with glBufferStorage can't be resized, so larger slots mean a new buffer
+*/
+static void allocate(upload_ring_t *self, size_t slot_size) {
+    for (int i = 0; i < UPLOAD_RING_SLOTS; i++)
+        wait_for(&self->_fences[i]);
+
+    if (self->buffer != 0) {
+        glBindBuffer(self->target, self->buffer);
+        glUnmapBuffer(self->target);
+        glDeleteBuffers(1, &self->buffer);
+    }
+
+    self->slot_size = (slot_size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+
+    glGenBuffers(1, &self->buffer);
+    glBindBuffer(self->target, self->buffer);
+    glBufferStorage(self->target, self->slot_size * UPLOAD_RING_SLOTS, NULL, PERSISTENT_FLAGS);
+
+    self->_mapped = (char *)glMapBufferRange(self->target, 0, self->slot_size * UPLOAD_RING_SLOTS, PERSISTENT_FLAGS);
+    if (self->_mapped == NULL) {
+        error("Unable to map upload buffer");
+    }
+}
+
+static void *begin(upload_ring_t *self, size_t size, size_t *offset) {
+    if (size > self->slot_size)
+        allocate(self, size + size / 2);
+
+    wait_for(&self->_fences[self->slot]);
+    glBindBuffer(self->target, self->buffer);
+
+    *offset = self->slot_size * self->slot;
+    return self->_mapped + *offset;
+}
+
+static void end(upload_ring_t *self) {
+    self->_fences[self->slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    self->slot = (self->slot + 1) % UPLOAD_RING_SLOTS;
+}
+
+upload_ring_t *init_upload_ring(GLenum target, size_t slot_size) {
+    upload_ring_t *self;
+    self = (upload_ring_t *)calloc(1, sizeof(upload_ring_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for upload ring.");
+    }
+
+    self->target = target;
+    self->begin = begin;
+    self->end = end;
+
+    allocate(self, slot_size > 0 ? slot_size : SLOT_ALIGNMENT);
+
+    return self;
+}
+
+void destroy_upload_ring(upload_ring_t *self) {
+    for (int i = 0; i < UPLOAD_RING_SLOTS; i++)
+        wait_for(&self->_fences[i]);
+
+    glBindBuffer(self->target, self->buffer);
+    glUnmapBuffer(self->target);
+    glDeleteBuffers(1, &self->buffer);
+
+    free(self);
+}
@@ -0,0 +1,87 @@
+#include "scheduler.h"
+
+// Share of each frame generations may take, the rest is left to drawing
+#define SCHEDULER_BUDGET 0.75
+// A frame this many times longer than it should be is an overrun
+#define SCHEDULER_OVERRUN 1.5
+// Longer gaps, such as the first frame or a stalled window, don't build up generations owed
+#define SCHEDULER_MAX_ELAPSED 0.25
+#define SCHEDULER_MAX_LIMIT (1 << 20)
+
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+static void set_rate(scheduler_t *self, double rate) {
+    self->rate = fmax(SCHEDULER_MIN_RATE, fmin(SCHEDULER_MAX_RATE, rate));
+}
+
+/**
+ * Halves back quickly when frames overrun, then grows a quarter at a time while the limit is what holds the rate back
+*/
+static void adapt_limit(scheduler_t *self, double elapsed) {
+    if (elapsed > self->frame_duration * SCHEDULER_OVERRUN && self->_ran > 1)
+        self->limit = self->_ran / 2 > 1 ? self->_ran / 2 : 1;
+    else if (self->_ran >= self->limit && self->limit < SCHEDULER_MAX_LIMIT)
+        self->limit += self->limit / 4 + 1;
+}
+
+static int run(scheduler_t *self, double elapsed, void (*step)(void)) {
+    adapt_limit(self, elapsed);
+
+    elapsed = fmin(fmax(elapsed, 0.0), SCHEDULER_MAX_ELAPSED);
+    self->_owed += self->rate * elapsed;
+
+    int due = (int)fmin(self->_owed, (double)self->limit);
+    double start = now();
+    int ran = 0;
+
+    // At least one generation runs when one is due, however slow, or a huge board would stop altogether
+    while (ran < due) {
+        step();
+        ran++;
+
+        if (now() - start > self->budget)
+            break;
+    }
+
+    self->_owed -= floor(self->_owed);
+    self->_ran = ran;
+    self->generations += ran;
+
+    self->_window += elapsed;
+    self->_window_generations += ran;
+
+    // Slow rates are measured over a couple of generations, not a second that mostly has none
+    if (self->_window >= fmax(1.0, 2.0 / self->rate)) {
+        self->achieved = self->_window_generations / self->_window;
+        self->_window = 0.0;
+        self->_window_generations = 0;
+    }
+
+    return ran;
+}
+
+scheduler_t *init_scheduler(double rate, double frame_duration) {
+    scheduler_t *self;
+    self = (scheduler_t *)calloc(1, sizeof(scheduler_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for scheduler.");
+    }
+
+    self->frame_duration = frame_duration;
+    self->budget = frame_duration * SCHEDULER_BUDGET;
+    self->limit = 1;
+    self->set_rate = set_rate;
+    self->run = run;
+
+    set_rate(self, rate);
+
+    return self;
+}
+
+void destroy_scheduler(scheduler_t *self) {
+    free(self);
+}
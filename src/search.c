@@ -0,0 +1,401 @@
+#include "search.h"
+
+#define WORD_BITS 64
+// Multiplying 8 cells of 0 or 1 by this gathers them into the top byte, the first cell in the lowest bit
+#define GATHER_BITS 0x0102040810204080ULL
+
+typedef struct shape_t {
+    int rows;
+    int columns;
+    bool *cells;
+} shape_t;
+
+typedef struct search_band_t {
+    search_t *search;
+    life_t *life;
+    // Board rows to pack, and rows of the lowest pattern cell to try
+    int first_packed;
+    int last_packed;
+    int first_row;
+    int last_row;
+    pattern_match_t *matches;
+    size_t num_matches;
+    size_t capacity;
+} search_band_t;
+
+static shape_t capture_shape(life_t *life) {
+    life_bounds_t bounds = life->bounds;
+    shape_t shape = {bounds.max_x - bounds.min_x + 1, bounds.max_y - bounds.min_y + 1, NULL};
+
+    shape.cells = (bool *)malloc((size_t)shape.rows * shape.columns * sizeof(bool));
+    if (shape.cells == NULL) {
+        error("Unable to allocate memory for search pattern");
+    }
+
+    for (int i = 0; i < shape.rows; i++)
+        memcpy(&shape.cells[(size_t)i * shape.columns], life->grid[bounds.min_x + i] + bounds.min_y, shape.columns);
+
+    return shape;
+}
+
+static bool same_shape(const shape_t *a, const shape_t *b) {
+    return a->rows == b->rows && a->columns == b->columns &&
+           memcmp(a->cells, b->cells, (size_t)a->rows * a->columns) == 0;
+}
+
+static shape_t transform_shape(const shape_t *shape, int orientation) {
+    bool turned = orientation % 2 == 1;
+    shape_t result = {turned ? shape->columns : shape->rows, turned ? shape->rows : shape->columns, NULL};
+
+    result.cells = (bool *)malloc((size_t)result.rows * result.columns * sizeof(bool));
+    if (result.cells == NULL) {
+        error("Unable to allocate memory for search pattern");
+    }
+
+    for (int i = 0; i < shape->rows; i++) {
+        for (int j = 0; j < shape->columns; j++) {
+            int r = i, c = orientation >= 4 ? shape->columns - 1 - j : j;
+            int rows = shape->rows, columns = shape->columns;
+
+            // A quarter turn sends (r, c) in a rows x columns box to (c, rows - 1 - r)
+            for (int turn = 0; turn < orientation % 4; turn++) {
+                int tmp = r;
+                r = c;
+                c = rows - 1 - tmp;
+                tmp = rows;
+                rows = columns;
+                columns = tmp;
+            }
+
+            result.cells[(size_t)r * result.columns + c] = shape->cells[(size_t)i * shape->columns + j];
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Live cells are tested first, on an empty stretch of board the first test rules out all 64 columns
+*/
+static void add_variant(search_t *self, const shape_t *shape, int pattern, int phase, int orientation) {
+    if (shape->rows > SEARCH_MAX_SIZE || shape->columns > SEARCH_MAX_SIZE) {
+        error("Search patterns can be at most 62 cells across");
+    }
+
+    search_variant_t *variants = (search_variant_t *)realloc(self->_variants, (self->num_variants + 1) * sizeof(search_variant_t));
+    if (variants == NULL) {
+        error("Unable to allocate memory for search pattern");
+    }
+    self->_variants = variants;
+
+    search_variant_t *variant = &variants[self->num_variants++];
+    *variant = (search_variant_t){pattern, phase, orientation, shape->rows, shape->columns, 0, NULL};
+
+    variant->tests = (search_test_t *)malloc((size_t)(shape->rows + 2) * (shape->columns + 2) * sizeof(search_test_t));
+    if (variant->tests == NULL) {
+        error("Unable to allocate memory for search pattern");
+    }
+
+    for (int alive = 1; alive >= 0; alive--) {
+        for (int i = -1; i <= shape->rows; i++) {
+            for (int j = -1; j <= shape->columns; j++) {
+                bool inside = i >= 0 && j >= 0 && i < shape->rows && j < shape->columns;
+                bool cell = inside && shape->cells[(size_t)i * shape->columns + j];
+
+                if (cell == alive)
+                    variant->tests[variant->num_tests++] = (search_test_t){i, j, cell};
+            }
+        }
+    }
+
+    if (shape->rows > self->_max_rows)
+        self->_max_rows = shape->rows;
+}
+
+static int add(search_t *self, pattern_t *pattern) {
+    int index = self->num_patterns++;
+    life_t *scratch = init_life(pattern->rows + 2, pattern->columns + 2);
+
+    // Spaceships move off, so let the board follow them while the phases are found
+    scratch->auto_grow = true;
+    pattern->load(pattern, scratch, 1, 1);
+
+    if (bounds_empty(scratch->bounds)) {
+        error("Search patterns need at least one live cell");
+    }
+
+    shape_t phases[SEARCH_MAX_PERIOD];
+    int period = 1;
+
+    phases[0] = capture_shape(scratch);
+
+    for (int generation = 1; generation < SEARCH_MAX_PERIOD; generation++) {
+        scratch->live(scratch);
+
+        if (bounds_empty(scratch->bounds))
+            break;
+
+        phases[period] = capture_shape(scratch);
+
+        if (same_shape(&phases[period], &phases[0])) {
+            free(phases[period].cells);
+            break;
+        }
+
+        period++;
+    }
+
+    // Not periodic within SEARCH_MAX_PERIOD, only the pattern as given is searched for
+    if (period == SEARCH_MAX_PERIOD || bounds_empty(scratch->bounds)) {
+        for (int phase = 1; phase < period; phase++)
+            free(phases[phase].cells);
+        period = 1;
+    }
+
+    shape_t *shapes = (shape_t *)malloc((size_t)period * 8 * sizeof(shape_t));
+    int num_shapes = 0;
+
+    if (shapes == NULL) {
+        error("Unable to allocate memory for search pattern");
+    }
+
+    for (int phase = 0; phase < period; phase++) {
+        for (int orientation = 0; orientation < 8; orientation++) {
+            shape_t shape = transform_shape(&phases[phase], orientation);
+            bool seen = false;
+
+            // Symmetric patterns, and oscillators whose phases are turns of each other, repeat shapes
+            for (int k = 0; k < num_shapes && !seen; k++)
+                seen = same_shape(&shape, &shapes[k]);
+
+            if (seen) {
+                free(shape.cells);
+                continue;
+            }
+
+            add_variant(self, &shape, index, phase, orientation);
+            shapes[num_shapes++] = shape;
+        }
+
+        free(phases[phase].cells);
+    }
+
+    for (int k = 0; k < num_shapes; k++)
+        free(shapes[k].cells);
+    free(shapes);
+    destroy_life(scratch);
+
+    return index;
+}
+
+static inline uint64_t *packed_row(search_t *self, int x) {
+    // Row -1 is the dead row below the board, each row starts with a dead word
+    return self->_packed + (size_t)(x + 1) * (self->_words + 2) + 1;
+}
+
+static void pack_row(life_t *life, int x, uint64_t *out, int words) {
+    out[-1] = 0;
+    out[words] = 0;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t word = 0;
+
+        for (int group = 0; group < WORD_BITS / 8; group++) {
+            int j = w * WORD_BITS + group * 8;
+            if (j >= life->columns)
+                break;
+
+            int count = life->columns - j < 8 ? life->columns - j : 8;
+            uint64_t cells = 0;
+
+            if (life->grid != NULL) {
+                memcpy(&cells, life->grid[x] + j, count);
+            } else {
+                for (int k = 0; k < count; k++)
+                    cells |= (uint64_t)life->get_alive(life, x, j + k) << (k * 8);
+            }
+
+            word |= ((cells * GATHER_BITS) >> 56) << (group * 8);
+        }
+
+        out[w] = word;
+    }
+}
+
+static void *pack_band(void *arg) {
+    search_band_t *band = (search_band_t *)arg;
+
+    for (int i = band->first_packed; i < band->last_packed; i++)
+        pack_row(band->life, i, packed_row(band->search, i), band->search->_words);
+
+    return NULL;
+}
+
+/**
+ * The 64 cells of the row starting at column 64 * word + offset, offset can be -1
+*/
+static inline uint64_t window(const uint64_t *row, int word, int offset) {
+    long start = (long)word * WORD_BITS + offset;
+    long index = start < 0 ? -1 : start / WORD_BITS;
+    int shift = start - index * WORD_BITS;
+
+    if (shift == 0)
+        return row[index];
+
+    return (row[index] >> shift) | (row[index + 1] << (WORD_BITS - shift));
+}
+
+static void add_match(search_band_t *band, const search_variant_t *variant, int x, int y) {
+    if (band->num_matches == band->capacity) {
+        band->capacity = band->capacity > 0 ? band->capacity * 2 : 64;
+        band->matches = (pattern_match_t *)realloc(band->matches, band->capacity * sizeof(pattern_match_t));
+
+        if (band->matches == NULL) {
+            error("Unable to allocate memory for search matches");
+        }
+    }
+
+    band->matches[band->num_matches++] = (pattern_match_t){
+        variant->pattern,
+        variant->phase,
+        variant->orientation,
+        {x, y, x + variant->rows - 1, y + variant->columns - 1},
+    };
+}
+
+static void *match_band(void *arg) {
+    search_band_t *band = (search_band_t *)arg;
+    search_t *self = band->search;
+    life_t *life = band->life;
+    life_bounds_t bounds = life->bounds;
+
+    for (int x = band->first_row; x < band->last_row; x++) {
+        for (int v = 0; v < self->num_variants; v++) {
+            const search_variant_t *variant = &self->_variants[v];
+            int last_column = life->columns - variant->columns;
+
+            if (x + variant->rows > life->rows || last_column < 0)
+                continue;
+
+            // A match has a live cell in its first column, so it starts inside the live bounds
+            int last_word = (bounds.max_y < last_column ? bounds.max_y : last_column) / WORD_BITS;
+
+            for (int word = bounds.min_y / WORD_BITS; word <= last_word; word++) {
+                uint64_t matches = ~(uint64_t)0;
+
+                for (int t = 0; t < variant->num_tests && matches != 0; t++) {
+                    const search_test_t *test = &variant->tests[t];
+                    uint64_t cells = window(packed_row(self, x + test->row), word, test->column);
+
+                    matches &= test->alive ? cells : ~cells;
+                }
+
+                if (word == last_column / WORD_BITS && last_column % WORD_BITS != WORD_BITS - 1)
+                    matches &= ((uint64_t)1 << (last_column % WORD_BITS + 1)) - 1;
+
+                for (; matches != 0; matches &= matches - 1)
+                    add_match(band, variant, x, word * WORD_BITS + __builtin_ctzll(matches));
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static pattern_match_t *find(search_t *self, life_t *life, size_t *num_matches) {
+    life_bounds_t bounds = life->bounds;
+
+    *num_matches = 0;
+    if (bounds_empty(bounds) || self->num_variants == 0)
+        return (pattern_match_t *)malloc(sizeof(pattern_match_t));
+
+    self->_words = (life->columns + WORD_BITS - 1) / WORD_BITS;
+    size_t size = (size_t)(life->rows + 2) * (self->_words + 2);
+
+    if (size > self->_packed_size) {
+        free(self->_packed);
+        self->_packed = (uint64_t *)malloc(size * sizeof(uint64_t));
+        if (self->_packed == NULL) {
+            error("Unable to allocate memory for packed board");
+        }
+        self->_packed_size = size;
+    }
+
+    memset(packed_row(self, -1) - 1, 0, (self->_words + 2) * sizeof(uint64_t));
+    memset(packed_row(self, life->rows) - 1, 0, (self->_words + 2) * sizeof(uint64_t));
+
+    // Matches are tried from every live row, and read the rows up to a pattern's height above and one below
+    int first_packed = bounds.min_x > 0 ? bounds.min_x - 1 : 0;
+    int last_packed = bounds.max_x + self->_max_rows + 1 < life->rows ? bounds.max_x + self->_max_rows + 1 : life->rows;
+    int rows = bounds.max_x - bounds.min_x + 1;
+    int num_threads = self->num_threads < rows ? self->num_threads : rows;
+
+    search_band_t *bands = (search_band_t *)calloc(num_threads, sizeof(search_band_t));
+    if (bands == NULL) {
+        error("Unable to allocate memory for search bands");
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        bands[i].search = self;
+        bands[i].life = life;
+        bands[i].first_packed = first_packed + (int)((long)(last_packed - first_packed) * i / num_threads);
+        bands[i].last_packed = first_packed + (int)((long)(last_packed - first_packed) * (i + 1) / num_threads);
+        bands[i].first_row = bounds.min_x + (int)((long)rows * i / num_threads);
+        bands[i].last_row = bounds.min_x + (int)((long)rows * (i + 1) / num_threads);
+    }
+
+    // get_alive is not safe to call from several threads on a board without a grid
+    if (life->grid != NULL) {
+        run_threads(pack_band, bands, sizeof(search_band_t), num_threads);
+    } else {
+        search_band_t all = bands[0];
+        all.last_packed = last_packed;
+        pack_band(&all);
+    }
+
+    run_threads(match_band, bands, sizeof(search_band_t), num_threads);
+
+    for (int i = 0; i < num_threads; i++)
+        *num_matches += bands[i].num_matches;
+
+    pattern_match_t *matches = (pattern_match_t *)malloc((*num_matches > 0 ? *num_matches : 1) * sizeof(pattern_match_t));
+    if (matches == NULL) {
+        error("Unable to allocate memory for search matches");
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < num_threads; i++) {
+        if (bands[i].num_matches > 0)
+            memcpy(matches + offset, bands[i].matches, bands[i].num_matches * sizeof(pattern_match_t));
+
+        offset += bands[i].num_matches;
+        free(bands[i].matches);
+    }
+
+    free(bands);
+
+    return matches;
+}
+
+search_t *init_search(void) {
+    search_t *self;
+    self = (search_t *)calloc(1, sizeof(search_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for search.");
+    }
+
+    self->num_threads = get_num_threads();
+    self->add = add;
+    self->find = find;
+
+    return self;
+}
+
+void destroy_search(search_t *self) {
+    for (int v = 0; v < self->num_variants; v++)
+        free(self->_variants[v].tests);
+
+    free(self->_variants);
+    free(self->_packed);
+    free(self);
+}
@@ -0,0 +1,353 @@
+#include "soup.h"
+
+// Generations of population kept per soup, a soup has settled once all of them repeat with a short period
+#define SOUP_HISTORY 256
+#define SOUP_MAX_PERIOD 60
+#define SOUP_CHECK_INTERVAL 32
+
+static const char *kind_names[] = {"still_life", "oscillator", "spaceship", "unclassified"};
+static const char digits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+typedef struct soup_tally_t {
+    long count;
+    int species;
+} soup_tally_t;
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void fill_soup(soup_search_t *self, life_t *life, long soup) {
+    uint64_t state = self->seed ^ splitmix64(&(uint64_t){(uint64_t)soup});
+    int offset = (self->board_size - self->soup_size) / 2;
+    uint64_t bits = 0;
+
+    for (int i = 0; i < life->rows; i++)
+        memset(life->grid[i], false, life->columns);
+
+    for (int i = 0; i < self->soup_size; i++) {
+        for (int j = 0; j < self->soup_size; j++) {
+            int bit = (i * self->soup_size + j) % 64;
+            if (bit == 0)
+                bits = splitmix64(&state);
+
+            life->grid[offset + i][offset + j] = (bits >> bit) & 1;
+        }
+    }
+
+    life->refresh(life);
+}
+
+static bool settled(const long *history, long generation) {
+    if (generation < SOUP_HISTORY)
+        return false;
+
+    for (int period = 1; period <= SOUP_MAX_PERIOD; period++) {
+        bool periodic = true;
+
+        for (long g = generation - SOUP_HISTORY + 1 + period; g <= generation && periodic; g++)
+            periodic = history[g % SOUP_HISTORY] == history[(g - period) % SOUP_HISTORY];
+
+        if (periodic)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Turns the torus so empty rows and columns, if there are any, sit on its edges. Two of each are picked
+ * where the board has them, so nothing across the edges is close enough to count as one object in the
+ * census, which does not wrap around.
+*/
+static void move_seams(life_t *life, bool *occupied, bool **rows) {
+    int empty_row = -1, empty_column = -1;
+    bool wide_row = false, wide_column = false;
+
+    memset(occupied, false, life->columns);
+
+    for (int i = 0; i < life->rows; i++) {
+        if (memchr(life->grid[i], true, life->columns) == NULL) {
+            bool wide = memchr(life->grid[(i + life->rows - 1) % life->rows], true, life->columns) == NULL;
+
+            if (!wide_row || wide) {
+                empty_row = i;
+                wide_row = wide;
+            }
+            continue;
+        }
+
+        for (int j = 0; j < life->columns; j++)
+            occupied[j] |= life->grid[i][j];
+    }
+
+    for (int j = 0; j < life->columns && !wide_column; j++) {
+        if (occupied[j])
+            continue;
+
+        empty_column = j;
+        wide_column = !occupied[(j + life->columns - 1) % life->columns];
+    }
+
+    if (empty_row >= 0 && empty_row != life->rows - 1) {
+        bool **grids[2] = {life->grid, life->shadow_grid};
+
+        for (int k = 0; k < 2; k++) {
+            for (int i = 0; i < life->rows; i++)
+                rows[i] = grids[k][(i + empty_row + 1) % life->rows];
+            memcpy(grids[k], rows, life->rows * sizeof(bool *));
+        }
+    }
+
+    if (empty_column >= 0 && empty_column != life->columns - 1) {
+        int shift = empty_column + 1;
+
+        // occupied has served its purpose and holds the cells that wrap around
+        for (int i = 0; i < life->rows; i++) {
+            memcpy(occupied, life->grid[i], shift);
+            memmove(life->grid[i], life->grid[i] + shift, life->columns - shift);
+            memcpy(life->grid[i] + life->columns - shift, occupied, shift);
+        }
+    }
+
+    life->refresh(life);
+}
+
+static void tally(soup_search_t *self) {
+    census_t *census = self->census;
+
+    if (census->num_species > self->_num_tallies) {
+        self->tallies = (long *)realloc(self->tallies, census->num_species * sizeof(long));
+        if (self->tallies == NULL) {
+            error("Unable to allocate memory for soup tallies");
+        }
+
+        memset(self->tallies + self->_num_tallies, 0, (census->num_species - self->_num_tallies) * sizeof(long));
+        self->_num_tallies = census->num_species;
+    }
+
+    for (int i = 0; i < census->num_species; i++)
+        self->tallies[i] += census->species[i].count;
+}
+
+static void write_zeros(FILE *file, int zeros) {
+    while (zeros > 0) {
+        if (zeros == 1) {
+            fputc('0', file);
+            zeros = 0;
+        } else if (zeros == 2 || zeros == 3) {
+            fputc(zeros == 2 ? 'w' : 'x', file);
+            zeros = 0;
+        } else {
+            int count = zeros < 39 ? zeros : 39;
+            fprintf(file, "y%c", digits[count - 4]);
+            zeros -= count;
+        }
+    }
+}
+
+void write_species_code(FILE *file, const census_species_t *species) {
+    switch (species->kind) {
+        case census_still_life:
+            fprintf(file, "xs%ld_", species->population);
+            break;
+        case census_oscillator:
+            fprintf(file, "xp%d_", species->period);
+            break;
+        case census_spaceship:
+            fprintf(file, "xq%d_", species->period);
+            break;
+        default:
+            fputs("unclassified", file);
+            return;
+    }
+
+    for (int strip = 0; strip < species->rows; strip += 5) {
+        int zeros = 0;
+
+        if (strip > 0)
+            fputc('z', file);
+
+        for (int j = 0; j < species->columns; j++) {
+            int value = 0;
+
+            for (int k = 0; k < 5 && strip + k < species->rows; k++)
+                value |= species->cells[(size_t)(strip + k) * species->columns + j] << k;
+
+            if (value == 0) {
+                zeros++;
+                continue;
+            }
+
+            write_zeros(file, zeros);
+            zeros = 0;
+            fputc(digits[value], file);
+        }
+    }
+}
+
+static int compare_tallies(const void *a, const void *b) {
+    const soup_tally_t *first = (const soup_tally_t *)a, *second = (const soup_tally_t *)b;
+
+    if (first->count != second->count)
+        return first->count > second->count ? -1 : 1;
+
+    return first->species - second->species;
+}
+
+/**
+ * Written beside the output file and renamed over it, so readers never see half a report
+*/
+static void write_report(soup_search_t *self) {
+    const char *temporary = str_concat(self->output_file, ".tmp");
+    FILE *file = fopen(temporary, "w");
+
+    if (file == NULL) {
+        error(str_concat("Unable to write census ", temporary));
+    }
+
+    soup_tally_t *tallies = (soup_tally_t *)malloc((self->_num_tallies > 0 ? self->_num_tallies : 1) * sizeof(soup_tally_t));
+    if (tallies == NULL) {
+        error("Unable to allocate memory for soup tallies");
+    }
+
+    int count = 0;
+    for (int i = 0; i < self->_num_tallies; i++)
+        if (self->tallies[i] > 0)
+            tallies[count++] = (soup_tally_t){self->tallies[i], i};
+
+    qsort(tallies, count, sizeof(soup_tally_t), compare_tallies);
+
+    fprintf(file, "# soups %ld\n# generations %ld\n# code kind period population count\n", self->soups, self->generations);
+
+    for (int i = 0; i < count; i++) {
+        const census_species_t *species = &self->census->species[tallies[i].species];
+
+        write_species_code(file, species);
+        fprintf(file, " %s %d %ld %ld\n", kind_names[species->kind], species->period, species->population, tallies[i].count);
+    }
+
+    if (fclose(file) != 0 || rename(temporary, self->output_file) != 0) {
+        error(str_concat("Unable to write census ", self->output_file));
+    }
+
+    free(tallies);
+    free((char *)temporary);
+}
+
+/**
+ * Every thread keeps one board for all of its soups, only the census is shared
+*/
+static void *run_soups(void *arg) {
+    soup_search_t *self = *(soup_search_t **)arg;
+    life_t *life = init_life(self->board_size, self->board_size);
+    long *history = (long *)malloc(SOUP_HISTORY * sizeof(long));
+    bool *occupied = (bool *)malloc(self->board_size * sizeof(bool));
+    bool **rows = (bool **)malloc(self->board_size * sizeof(bool *));
+
+    if (history == NULL || occupied == NULL || rows == NULL) {
+        error("Unable to allocate memory for soup search");
+    }
+
+    life->torus = true;
+    // Every soup starts busy and is dropped once it settles, switching sweeps would only fill the log
+    life->adaptive = false;
+
+    for (;;) {
+        long soup = __atomic_fetch_add(&self->_next_soup, 1, __ATOMIC_RELAXED);
+        if (soup >= self->_last_soup)
+            break;
+
+        fill_soup(self, life, soup);
+
+        long generation = 0;
+        history[0] = life->stats.population;
+
+        while (generation < self->max_generations) {
+            life->live(life);
+            generation++;
+            history[generation % SOUP_HISTORY] = life->stats.population;
+
+            if (generation % SOUP_CHECK_INTERVAL == 0 && settled(history, generation))
+                break;
+        }
+
+        move_seams(life, occupied, rows);
+
+        pthread_mutex_lock(&self->_lock);
+
+        self->census->take(self->census, life);
+        tally(self);
+        self->soups++;
+        self->generations += generation;
+
+        if (self->soups % self->report_interval == 0)
+            write_report(self);
+
+        pthread_mutex_unlock(&self->_lock);
+    }
+
+    free(history);
+    free(occupied);
+    free(rows);
+    destroy_life(life);
+
+    return NULL;
+}
+
+static void run(soup_search_t *self, long num_soups) {
+    if (self->soup_size > self->board_size) {
+        error("Soups have to fit on the board");
+    }
+
+    self->_next_soup = self->soups;
+    self->_last_soup = self->soups + num_soups;
+
+    soup_search_t **args = (soup_search_t **)malloc(self->num_threads * sizeof(soup_search_t *));
+    if (args == NULL) {
+        error("Unable to allocate memory for soup search");
+    }
+
+    for (int i = 0; i < self->num_threads; i++)
+        args[i] = self;
+
+    run_threads(run_soups, args, sizeof(soup_search_t *), self->num_threads);
+    write_report(self);
+
+    free(args);
+}
+
+soup_search_t *init_soup_search(const char *output_file) {
+    soup_search_t *self;
+    self = (soup_search_t *)calloc(1, sizeof(soup_search_t));
+    if (self == NULL) {
+        error("Unable to allocate memory for soup search.");
+    }
+
+    self->soup_size = 16;
+    self->board_size = 64;
+    self->seed = time(0);
+    self->max_generations = 10000;
+    self->num_threads = get_num_threads();
+    self->report_interval = 10000;
+    self->output_file = output_file;
+    self->run = run;
+
+    // Soup boards are small, the census runs on the thread that finished the soup
+    self->census = init_census();
+    self->census->num_threads = 1;
+
+    pthread_mutex_init(&self->_lock, NULL);
+
+    return self;
+}
+
+void destroy_soup_search(soup_search_t *self) {
+    pthread_mutex_destroy(&self->_lock);
+    destroy_census(self->census);
+    free(self->tallies);
+    free(self);
+}
@@ -0,0 +1,30 @@
+#include "utils/thread_utils.h"
+
+int get_num_threads(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+}
+
+void run_threads(void *(*task)(void *), void *args, size_t arg_size, int count) {
+    if (count == 1) {
+        task(args);
+        return;
+    }
+
+    pthread_t *threads = (pthread_t *)calloc(count, sizeof(pthread_t));
+    if (threads == NULL) {
+        error("Unable to allocate memory for threads");
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (pthread_create(&threads[i], NULL, task, (char *)args + i * arg_size) != 0)
+            error("Unable to start thread");
+    }
+
+    for (int i = 0; i < count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "census.h"
+#include "soup.h"
+
+/**
+ * Takes a census of lone oscillators in every phase and checks each is one object tallied under its own code,
+ * including the toad and beacon whose cells fall apart into two pieces on one of their phases.
+ * Usage: census_test
+*/
+
+#define TEST_BOARD_SIZE 64
+
+typedef struct census_case_t {
+    const char *name;
+    const char *code;
+    int period;
+    int rows;
+    const char *cells[4];
+} census_case_t;
+
+static const census_case_t cases[] = {
+    {"blinker", "xp2_111", 2, 1, {"OOO"}},
+    {"toad", "xp2_2331", 2, 2, {".OOO", "OOO."}},
+    {"beacon", "xp2_c813", 2, 4, {"OO..", "OO..", "..OO", "..OO"}},
+    {"block", "xs4_33", 1, 2, {"OO", "OO"}},
+};
+
+static void place(life_t *life, const census_case_t *pattern, int x, int y) {
+    for (int i = 0; i < life->rows; i++)
+        memset(life->grid[i], false, life->columns);
+
+    for (int i = 0; i < pattern->rows; i++)
+        for (int j = 0; pattern->cells[i][j] != '\0'; j++)
+            life->grid[x + i][y + j] = pattern->cells[i][j] == 'O';
+
+    life->refresh(life);
+}
+
+static bool check_phase(census_t *census, life_t *life, const census_case_t *pattern, int phase) {
+    char code[256] = {0};
+
+    census->take(census, life);
+
+    if (census->num_objects != 1) {
+        printf("  %s phase %d: %zu objects\n", pattern->name, phase, census->num_objects);
+        return false;
+    }
+
+    const census_species_t *species = &census->species[census->objects[0].species];
+    FILE *file = fmemopen(code, sizeof(code) - 1, "w");
+
+    if (file == NULL) {
+        error("Unable to open a buffer for species codes");
+    }
+
+    write_species_code(file, species);
+    fclose(file);
+
+    if (species->period != pattern->period || strcmp(code, pattern->code) != 0) {
+        printf("  %s phase %d: %s with period %d, expected %s\n", pattern->name, phase, code, species->period, pattern->code);
+        return false;
+    }
+
+    return true;
+}
+
+static bool test_case(census_t *census, const census_case_t *pattern) {
+    life_t *life = init_life(TEST_BOARD_SIZE, TEST_BOARD_SIZE);
+    bool ok = true;
+
+    life->torus = true;
+
+    // In the middle and next to the edges, without wrapping around them
+    int positions[][2] = {{30, 30}, {1, 1}, {TEST_BOARD_SIZE - 6, TEST_BOARD_SIZE - 6}};
+
+    for (int k = 0; k < 3; k++) {
+        place(life, pattern, positions[k][0], positions[k][1]);
+
+        for (int phase = 0; phase < 2 * pattern->period; phase++) {
+            ok &= check_phase(census, life, pattern, phase);
+            life->live(life);
+        }
+    }
+
+    printf("%s: %s\n", pattern->name, ok ? "ok" : "FAILED");
+    destroy_life(life);
+
+    return ok;
+}
+
+int main(void) {
+    census_t *census = init_census();
+    int failed = 0;
+
+    for (int threads = 1; threads <= 4; threads *= 4) {
+        census->num_threads = threads;
+        printf("%d census threads\n", threads);
+
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+            failed += !test_case(census, &cases[i]);
+    }
+
+    destroy_census(census);
+
+    return failed == 0 ? 0 : 1;
+}
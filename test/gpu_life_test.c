@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+#include "life.h"
+
+/**
+ * Steps the GPU board and the in memory board side by side from the same cells and compares them every
+ * generation. It needs no window or display, an OpenGL 4.6 driver such as Mesa's llvmpipe is enough.
+ * Usage: gpu_life_test [generations]
+*/
+
+#define TEST_SEED 1234
+
+static const int board_sizes[][2] = {
+    {300, 400},
+    {97, 777},
+    {5, 33},
+    {64, 64},
+    {130, 31},
+};
+
+/**
+ * A pbuffer backed context on the surfaceless platform when the driver has one, so no display server is needed
+*/
+static void open_headless_context(void) {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    if (get_platform_display != NULL)
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+#endif
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        error("Unable to initialize EGL");
+    }
+
+    static const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE,
+    };
+    static const EGLint surface_attributes[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+    static const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 6,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE,
+    };
+
+    EGLConfig config;
+    EGLint num_configs = 0;
+
+    if (!eglChooseConfig(display, config_attributes, &config, 1, &num_configs) || num_configs == 0) {
+        error("No EGL config with OpenGL pbuffers");
+    }
+
+    eglBindAPI(EGL_OPENGL_API);
+
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attributes);
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+
+    if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+        error("Unable to create an OpenGL 4.6 context");
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        error("Failed to initialize GLAD");
+    }
+}
+
+static long compare_cells(life_t *gpu, life_t *cpu, int generation) {
+    long mismatches = 0;
+
+    for (int i = 0; i < cpu->rows; i++) {
+        for (int j = 0; j < cpu->columns; j++) {
+            if (gpu->get_alive(gpu, i, j) == cpu->get_alive(cpu, i, j))
+                continue;
+
+            if (mismatches == 0)
+                printf("  generation %d: cell (%d, %d) differs\n", generation, i, j);
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+static long compare_stats(life_t *gpu, life_t *cpu, int generation) {
+    const life_stats_t *g = &gpu->stats, *c = &cpu->stats;
+
+    if (g->generation == c->generation && g->population == c->population && g->births == c->births && g->deaths == c->deaths &&
+        g->density == c->density)
+        return 0;
+
+    printf("  generation %d: gpu generation %ld population %ld births %ld deaths %ld, cpu %ld %ld %ld %ld\n",
+           generation, g->generation, g->population, g->births, g->deaths, c->generation, c->population, c->births, c->deaths);
+    return 1;
+}
+
+/**
+ * Edits go through both boards at set generations, so uploads of changed rows are covered too
+*/
+static void edit_both(life_t *gpu, life_t *cpu, int generation) {
+    life_t *boards[2] = {gpu, cpu};
+    int rows = cpu->rows, columns = cpu->columns;
+    int points[] = {1, 1, 2, 2, 3, 1, rows - 1, columns - 1};
+
+    for (int k = 0; k < 2; k++) {
+        life_t *life = boards[k];
+
+        if (generation == 20)
+            life->fill(life, (life_bounds_t){2, 3, rows / 3, columns / 2}, true);
+        else if (generation == 40)
+            life->edit_points(life, points, 4, life_xor);
+        else if (generation == 60) {
+            for (int j = -1; j <= 1; j++)
+                life->set_alive(life, rows / 2, columns / 2 + j, true);
+        }
+    }
+}
+
+static bool test_board(int rows, int columns, int generations) {
+    life_t *gpu = init_gpu_life(rows, columns);
+    life_t *cpu = init_life(rows, columns);
+    long failures = 0;
+
+    srand(TEST_SEED);
+    gpu->seed(gpu);
+
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < columns; j++)
+            cpu->grid[i][j] = gpu->get_alive(gpu, i, j);
+    cpu->refresh(cpu);
+
+    failures += compare_cells(gpu, cpu, 0);
+
+    for (int generation = 1; generation <= generations && failures == 0; generation++) {
+        edit_both(gpu, cpu, generation);
+
+        gpu->live(gpu);
+        cpu->live(cpu);
+
+        // The GPU board's stats come back with its cells, so the cells are read first
+        failures += compare_cells(gpu, cpu, generation);
+        failures += compare_stats(gpu, cpu, generation);
+    }
+
+    printf("%dx%d: %s\n", rows, columns, failures == 0 ? "ok" : "FAILED");
+
+    destroy_life(gpu);
+    destroy_life(cpu);
+
+    return failures == 0;
+}
+
+int main(int argc, char **argv) {
+    int generations = argc > 1 ? atoi(argv[1]) : 200;
+    int failed = 0;
+
+    open_headless_context();
+    printf("%s, %s, %d generations\n", glGetString(GL_RENDERER), glGetString(GL_VERSION), generations);
+
+    for (size_t i = 0; i < sizeof(board_sizes) / sizeof(board_sizes[0]); i++)
+        failed += !test_board(board_sizes[i][0], board_sizes[i][1], generations);
+
+    return failed == 0 ? 0 : 1;
+}